@@ -0,0 +1,192 @@
+#include "dancing_cells.h"
+
+void DancingCells::generate(Dlx::Driver *driver) {
+  Dlx::HNode *hnodes = driver->hnodes;
+  Dlx::VNode *vnodes = driver->vnodes;
+
+  items.assign(driver->hnodes_size, {0, 0, -1});
+  item.clear();
+  for (Dlx::HNode::HorizontalIterator i(hnodes[0].right); i != hnodes; ++i) {
+    items[&*i - hnodes].pos = item.size();
+    item.push_back(&*i - hnodes);
+  }
+  active = item.size();
+
+  // Number nodes option by option, skipping the item headers
+  std::vector<int> vnode_id(driver->vnodes_size, -1);
+  nodes.clear();
+  node_source.clear();
+  option_begin.clear();
+  for (int i = driver->hnodes_size; i < driver->vnodes_size; i++) {
+    Dlx::VNode *node = &vnodes[i];
+    if (node->top == nullptr) {
+      option_begin.push_back(nodes.size());
+      continue;
+    }
+    int c = node->top - vnodes;
+    if (items[c].pos == -1) {
+      continue;
+    }
+    vnode_id[i] = nodes.size();
+    nodes.push_back({c, int(option_begin.size()) - 1, -1});
+    node_source.push_back(node);
+  }
+
+  // Lay each item's segment out in its list order so options are first
+  // tried in the same order as Dlx would
+  set.clear();
+  for (int c : item) {
+    items[c].begin = set.size();
+    Dlx::VNode *top = &vnodes[c];
+    for (auto j = ++Dlx::VNode::VerticalIterator(top); j != top; ++j) {
+      int k = vnode_id[&*j - vnodes];
+      nodes[k].loc = set.size();
+      set.push_back(k);
+    }
+    items[c].size = set.size() - items[c].begin;
+  }
+}
+
+int DancingCells::selectItem() const {
+  if (active == 0) {
+    return -1;
+  }
+  int min_c = item[0];
+  int min_value = items[min_c].size;
+  for (int i = 1; i < active; i++) {
+    if (items[item[i]].size < min_value) {
+      min_c = item[i];
+      min_value = items[min_c].size;
+    }
+  }
+  return min_c;
+}
+
+void DancingCells::hide(int node) {
+  int o = nodes[node].option;
+  for (int k = option_begin[o]; k < option_begin[o + 1]; k++) {
+    if (k == node) {
+      continue;
+    }
+    Item &c = items[nodes[k].item];
+    int last = c.begin + --c.size;
+    int other = set[last];
+    int loc = nodes[k].loc;
+    set[loc] = other;
+    nodes[other].loc = loc;
+    set[last] = k;
+    nodes[k].loc = last;
+  }
+}
+
+void DancingCells::unhide(int node) {
+  int o = nodes[node].option;
+  for (int k = option_begin[o + 1] - 1; k >= option_begin[o]; k--) {
+    if (k != node) {
+      items[nodes[k].item].size++;
+    }
+  }
+}
+
+void DancingCells::cover(int c) {
+  int pos = items[c].pos;
+  int last = item[--active];
+  item[pos] = last;
+  items[last].pos = pos;
+  item[active] = c;
+  items[c].pos = active;
+
+  for (int i = items[c].begin; i < items[c].begin + items[c].size; i++) {
+    hide(set[i]);
+  }
+}
+
+void DancingCells::uncover(int c) {
+  for (int i = items[c].begin + items[c].size - 1; i >= items[c].begin; i--) {
+    unhide(set[i]);
+  }
+  active++;
+}
+
+void DancingCells::choose(int node) {
+  int o = nodes[node].option;
+  for (int k = option_begin[o]; k < option_begin[o + 1]; k++) {
+    if (k != node) {
+      cover(nodes[k].item);
+    }
+  }
+}
+
+void DancingCells::unchoose(int node) {
+  int o = nodes[node].option;
+  for (int k = option_begin[o + 1] - 1; k >= option_begin[o]; k--) {
+    if (k != node) {
+      uncover(nodes[k].item);
+    }
+  }
+}
+
+std::uint64_t DancingCells::solveAll(Dlx::Driver *driver,
+                                     const Dlx::Visit &visit) {
+  generate(driver);
+  stats = {};
+
+  // Position in set of the node chosen at each level
+  std::vector<int> backtracking(item.size());
+  std::vector<Dlx::VNode *> solution(item.size());
+
+  std::uint64_t count = 0;
+  int level = 0;
+  for (;;) {
+    int c = selectItem();
+    int p;
+
+    if (c == -1) {
+      count++;
+      if (!visit({solution.data(), std::size_t(level)}) || level == 0) {
+        return count;
+      }
+
+      // Resume from the deepest choice as if it had failed
+      level--;
+      p = backtracking[level];
+      c = nodes[set[p]].item;
+      unchoose(set[p]);
+      p++;
+    } else {
+      cover(c);
+      p = items[c].begin;
+    }
+
+    // Backtrack until our current item has options left
+    while (p == items[c].begin + items[c].size) {
+      uncover(c);
+
+      if (level == 0) {
+        return count;
+      }
+
+      level--;
+      p = backtracking[level];
+      c = nodes[set[p]].item;
+      unchoose(set[p]);
+      p++;
+    }
+
+    choose(set[p]);
+    backtracking[level] = p;
+    solution[level] = node_source[set[p]];
+
+    stats.nodes++;
+    level++;
+  }
+}
+
+std::vector<Dlx::VNode *> DancingCells::solve(Dlx::Driver *driver) {
+  std::vector<Dlx::VNode *> solution;
+  solveAll(driver, [&](std::span<Dlx::VNode *const> found) {
+    solution.assign(found.begin(), found.end());
+    return false;
+  });
+  return solution;
+}
@@ -0,0 +1,82 @@
+/*
+ * Dancing cells exact cover solver
+ *
+ * Read The Art Of Computer Programming Volume 4 Pre-Fascicle 7A by Knuth
+ *
+ * Dancing links spend most of their time chasing up and down pointers
+ * scattered across the node array, which caches and prefetchers handle
+ * poorly on large matrices. Dancing cells keep the same search but store
+ * each set as a contiguous array instead of a ring.
+ *
+ * A sparse set is an array whose first size entries are the members, plus
+ * an inverse array giving each element's position. Removing an element
+ * swaps it with the last member and shrinks size. As long as removals are
+ * undone in the reverse order, restoring only has to grow size again since
+ * the removed element is still sitting just past the end.
+ *
+ * Active items form one sparse set. Each item also owns a segment of the
+ * set array holding the nodes of its remaining options. Hiding an option
+ * removes its other nodes from their items' segments, covering an item
+ * removes it from the active items and hides every option in its segment.
+ *
+ * The engine reads the matrix built by any Dlx::Driver without changing
+ * it and returns solutions as nodes of that matrix, so drivers can switch
+ * engines without translating anything. The driver's matrix must not be
+ * mid solve when it is read.
+ */
+
+#pragma once
+#include "dlx.h"
+
+#include <cstdint>
+#include <vector>
+
+struct DancingCells {
+  // An item's segment of set, its first size entries are live nodes. pos
+  // is its index in the active items.
+  struct Item {
+    int begin;
+    int size;
+    int pos;
+  };
+
+  // loc is the node's index in set
+  struct Node {
+    int item;
+    int option;
+    int loc;
+  };
+
+  // Indexed by the driver's header index
+  std::vector<Item> items;
+
+  // Active items, the first active entries are uncovered
+  std::vector<int> item;
+  int active;
+
+  std::vector<int> set;
+
+  // Nodes of an option are contiguous, option o owns
+  // [option_begin[o], option_begin[o + 1])
+  std::vector<Node> nodes;
+  std::vector<int> option_begin;
+
+  // The driver node each of our nodes was built from
+  std::vector<Dlx::VNode *> node_source;
+
+  Dlx::Stats stats;
+
+  void generate(Dlx::Driver *driver);
+
+  int selectItem() const;
+
+  void hide(int node);
+  void unhide(int node);
+  void cover(int c);
+  void uncover(int c);
+  void choose(int node);
+  void unchoose(int node);
+
+  std::uint64_t solveAll(Dlx::Driver *driver, const Dlx::Visit &visit);
+  std::vector<Dlx::VNode *> solve(Dlx::Driver *driver);
+};
@@ -0,0 +1,151 @@
+#include "dancing_cells_test.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+// Options of an n x n latin square with its first row fixed to 0 1 2 ...
+static std::vector<std::vector<int>> latinSquare(int n) {
+  std::vector<std::vector<int>> options;
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      for (int k = 0; k < n; k++) {
+        if (i == 0 && j != k) {
+          continue;
+        }
+        options.push_back({i * n + j + 1, n * n + i * n + k + 1,
+                           2 * n * n + j * n + k + 1});
+      }
+    }
+  }
+  return options;
+}
+
+bool DancingCellsTest::validateSolution(
+    std::span<Dlx::VNode *const> solution) {
+  std::vector<int> covered(driver->hnodes_size);
+  for (Dlx::VNode *i : solution) {
+    Dlx::VNode::HorizontalIterator j(i);
+    do {
+      covered[j->top - driver->vnodes]++;
+    } while (++j != i);
+  }
+  for (Dlx::HNode::HorizontalIterator i(driver->hnodes[0].right);
+       i != driver->hnodes; ++i) {
+    if (covered[&*i - driver->hnodes] != 1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void DancingCellsTest::compareSolutions() {
+  int invalid = 0;
+  auto validate = [&](std::span<Dlx::VNode *const> solution) {
+    invalid += !validateSolution(solution);
+    return true;
+  };
+
+  Dlx dlx;
+  std::uint64_t dlx_count = dlx.solveAll(driver, validate);
+  DancingCells cells;
+  std::uint64_t cells_count = cells.solveAll(driver, validate);
+
+  if (dlx_count != cells_count || invalid != 0) {
+    std::cout << "FAILED solution count dlx: " << dlx_count
+              << " cells: " << cells_count << " invalid: " << invalid << "\n";
+  }
+}
+
+void DancingCellsTest::benchmark(int runs) {
+  auto count = [](std::span<Dlx::VNode *const>) { return true; };
+
+  auto start = std::chrono::steady_clock::now();
+  Dlx dlx;
+  for (int i = 0; i < runs; i++) {
+    dlx.solveAll(driver, count);
+  }
+  auto middle = std::chrono::steady_clock::now();
+  DancingCells cells;
+  for (int i = 0; i < runs; i++) {
+    cells.solveAll(driver, count);
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  using ms = std::chrono::duration<double, std::milli>;
+  std::cout << "dlx: " << ms(middle - start).count() / runs << "ms "
+            << dlx.stats.nodes << " nodes cells: "
+            << ms(end - middle).count() / runs << "ms " << cells.stats.nodes
+            << " nodes\n";
+}
+
+void DancingCellsTest::compareRandom(int count, std::uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  for (int n = 0; n < count; n++) {
+    int items = 2 + rng() % 14;
+    std::vector<std::vector<int>> options =
+        randomOptions(items, 1 + rng() % 30, rng);
+
+    RandomDriver driver;
+    driver.generate(items, options);
+    DancingCellsTest(&driver).compareSolutions();
+  }
+  std::cout << "Compared " << count << " random matrices\n";
+}
+
+void DancingCellsTest::benchmarkLatin(int n) {
+  std::vector<std::vector<int>> options = latinSquare(n);
+
+  // Dlx leaves the matrix mid solve when stopped at a solution, so each
+  // engine gets its own copy. The cells time includes building its arrays.
+  RandomDriver dlx_driver;
+  dlx_driver.generate(3 * n * n, options);
+  RandomDriver cells_driver;
+  cells_driver.generate(3 * n * n, options);
+
+  auto start = std::chrono::steady_clock::now();
+  Dlx dlx;
+  std::vector<Dlx::VNode *> dlx_solution = dlx.solve(&dlx_driver);
+  auto middle = std::chrono::steady_clock::now();
+  DancingCells cells;
+  std::vector<Dlx::VNode *> cells_solution = cells.solve(&cells_driver);
+  auto end = std::chrono::steady_clock::now();
+
+  // Every solution fills each of the n * n cells once
+  if (dlx_solution.size() != std::size_t(n * n) ||
+      cells_solution.size() != std::size_t(n * n)) {
+    std::cout << "FAILED latin square " << n << " dlx: " << dlx_solution.size()
+              << " cells: " << cells_solution.size() << " options\n";
+  }
+
+  using ms = std::chrono::duration<double, std::milli>;
+  std::cout << "latin " << n << " with "
+            << dlx_driver.vnodes_size * sizeof(Dlx::VNode) / (1 << 20)
+            << "MB of nodes dlx: " << ms(middle - start).count() << "ms "
+            << dlx.stats.nodes << " nodes cells: "
+            << ms(end - middle).count() << "ms " << cells.stats.nodes
+            << " nodes\n";
+}
+
+#ifdef DANCING_CELLS_TEST_MAIN
+
+int main() {
+  DancingCellsTest::compareRandom(2000, 1);
+
+  // Enumerating the 6x6 latin squares with a fixed first row is large
+  // enough to time but fits in cache
+  const int n = 6;
+  RandomDriver driver;
+  driver.generate(3 * n * n, latinSquare(n));
+  DancingCellsTest test(&driver);
+  test.compareSolutions();
+  test.benchmark(1);
+
+  // An 80x80 square has about 50MB of nodes, so every solve runs from
+  // memory rather than cache
+  DancingCellsTest::benchmarkLatin(80);
+
+  return 0;
+}
+
+#endif
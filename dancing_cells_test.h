@@ -0,0 +1,93 @@
+#pragma once
+#include "dancing_cells.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Matrix built from a list of options given as item indices from 1, also
+// used by the dlx and dlx_bitset tests
+class RandomDriver : public Dlx::Driver {
+public:
+  std::vector<Dlx::HNode> hnodes_owner;
+  std::vector<Dlx::VNode> vnodes_owner;
+
+  void generate(int items, const std::vector<std::vector<int>> &options) {
+    int nodes = items + 1 + 1;
+    for (auto &i : options) {
+      nodes += i.size() + 1;
+    }
+    // Headers link to ones not yet added, so the vectors must not reallocate
+    hnodes_owner.reserve(items + 1);
+    vnodes_owner.reserve(nodes);
+    Dlx::HNode *h = hnodes_owner.data();
+    Dlx::VNode *v = vnodes_owner.data();
+
+    hnodes_owner.emplace_back(nullptr, h + 1);
+    vnodes_owner.emplace_back(nullptr, nullptr, nullptr);
+    for (int i = 1; i <= items; i++) {
+      hnodes_owner.emplace_back(h + i - 1, h + i + 1);
+      vnodes_owner.emplace_back(0, v + i, v + i);
+    }
+    hnodes_owner.back().right = &hnodes_owner[0];
+    hnodes_owner.front().left = &hnodes_owner[items];
+
+    Dlx::VNode *prev_spacer = &vnodes_owner[0];
+    for (auto &option : options) {
+      vnodes_owner.emplace_back(nullptr, prev_spacer + 1, nullptr);
+      prev_spacer = &vnodes_owner.back();
+      for (int i : option) {
+        Dlx::VNode *top = &vnodes_owner[i];
+        Dlx::VNode *bottom = top->up;
+        vnodes_owner.emplace_back(top, bottom, top);
+        top->up = &vnodes_owner.back();
+        bottom->down = &vnodes_owner.back();
+        top->size++;
+      }
+      prev_spacer->down = &vnodes_owner.back();
+    }
+    vnodes_owner.emplace_back(nullptr, prev_spacer + 1, nullptr);
+
+    hnodes = hnodes_owner.data();
+    vnodes = vnodes_owner.data();
+    hnodes_size = hnodes_owner.size();
+    vnodes_size = vnodes_owner.size();
+    solution_size = items;
+  }
+};
+
+// Options of a random matrix with a 1 in 4 chance of each item being in
+// each option, shared by the tests comparing engines on random matrices
+inline std::vector<std::vector<int>> randomOptions(int items, int count,
+                                                   std::mt19937_64 &rng) {
+  std::vector<std::vector<int>> options(count);
+  for (auto &option : options) {
+    for (int i = 1; i <= items; i++) {
+      if (rng() % 4 == 0) {
+        option.push_back(i);
+      }
+    }
+    if (option.empty()) {
+      option.push_back(1 + rng() % items);
+    }
+  }
+  return options;
+}
+
+// Differential tests of DancingCells against Dlx on the same matrices
+class DancingCellsTest {
+public:
+  Dlx::Driver *driver;
+  DancingCellsTest(Dlx::Driver *driver_) : driver(driver_) {}
+
+  bool validateSolution(std::span<Dlx::VNode *const> solution);
+  void compareSolutions();
+  void benchmark(int runs);
+
+  // Compare both engines on count random matrices
+  static void compareRandom(int count, std::uint64_t seed);
+
+  // Time the first solution of an n x n latin square with a fixed first
+  // row, large n giving node arrays far bigger than the caches
+  static void benchmarkLatin(int n);
+};
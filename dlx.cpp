@@ -1,4 +1,13 @@
 #include "dlx.h"
+#include "dlx_trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 Dlx::VNode *Dlx::getVNode(HNode *node) { return &vnodes[node - hnodes]; }
 
@@ -31,19 +40,86 @@ void Dlx::horizontalRemove(HNode *node) {
 }
 
 Dlx::HNode *Dlx::selectItem() {
+  if (forced != nullptr) {
+    HNode *i = forced;
+    forced = nullptr;
+    if (i->left->right == i && size(i) == 1) {
+      stats.forced++;
+      return i;
+    }
+  }
+
+  if (config.weighted) {
+    return selectWeightedItem();
+  }
+
   int hnodes_size = 0;
   HNode *min_i = hnodes[0].right;
   int min_value = size(min_i);
+  int ties = 0;
   for (HNode::HorizontalIterator i(hnodes[0].right); i != hnodes; ++i) {
     if (size(i) < min_value) {
       min_value = size(i);
       min_i = i;
+      ties = 1;
+    } else if (config.randomize && size(i) == min_value) {
+      // Reservoir sample so each tied item is equally likely
+      ties++;
+      if (rng() % ties == 0) {
+        min_i = i;
+      }
     }
     hnodes_size++;
   }
   return min_i;
 }
 
+// Compare size / weight by cross multiplying, so empty items come first
+Dlx::HNode *Dlx::selectWeightedItem() {
+  HNode *min_i = hnodes[0].right;
+  double min_size = size(min_i);
+  double min_weight = item_weights[min_i - hnodes];
+  int ties = 0;
+  for (HNode::HorizontalIterator i(hnodes[0].right); i != hnodes; ++i) {
+    double lhs = size(i) * min_weight;
+    double rhs = min_size * item_weights[i - hnodes];
+    if (lhs < rhs) {
+      min_size = size(i);
+      min_weight = item_weights[i - hnodes];
+      min_i = i;
+      ties = 1;
+    } else if (config.randomize && lhs == rhs) {
+      ties++;
+      if (rng() % ties == 0) {
+        min_i = i;
+      }
+    }
+  }
+  return min_i;
+}
+
+// Start every weight at 1 unless they were learned on as many items
+void Dlx::prepareWeights(Driver *driver) {
+  if (config.weighted &&
+      item_weights.size() != std::size_t(driver->hnodes_size)) {
+    item_weights.assign(driver->hnodes_size, 1);
+    weight_gain = 1;
+  }
+}
+
+void Dlx::bumpWeight(HNode *node) {
+  item_weights[node - hnodes] += weight_gain;
+  weight_gain /= config.weight_decay;
+
+  // Scale everything down before the gain overflows, which keeps ratios
+  if (weight_gain > 1e100) {
+    for (double &weight : item_weights) {
+      weight *= 1e-100;
+    }
+    weight_gain *= 1e-100;
+  }
+}
+
 void Dlx::hide(VNode *node) {
   for (auto i = ++VNode::HorizontalIterator(node); i != node; ++i) {
     verticalRemove(i);
@@ -63,9 +139,15 @@ void Dlx::cover(HNode *node) {
   }
 
   horizontalRemove(node);
+  if (learning) {
+    signature ^= item_keys[node - hnodes];
+  }
 }
 
 void Dlx::uncover(HNode *node) {
+  if (learning) {
+    signature ^= item_keys[node - hnodes];
+  }
   horizontalInsert(node);
 
   for (auto i = --VNode::VerticalIterator(getVNode(node)); i != getVNode(node);
@@ -74,30 +156,398 @@ void Dlx::uncover(HNode *node) {
   }
 }
 
-std::vector<Dlx::VNode *> Dlx::solve(Dlx::Driver *driver) {
+bool Dlx::hideChecked(VNode *node) {
+  for (auto i = ++VNode::HorizontalIterator(node); i != node; ++i) {
+    verticalRemove(i);
+    if (i->top->size <= 1 && item_stamp[i->top - vnodes] != stamp) {
+      if (i->top->size == 1) {
+        forced = topHNode(i);
+        continue;
+      }
+      if (config.weighted) {
+        bumpWeight(topHNode(i));
+      }
+      for (; i != node; --i) {
+        verticalInsert(i);
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Dlx::coverChecked(HNode *node) {
+  for (auto i = ++VNode::VerticalIterator(getVNode(node)); i != getVNode(node);
+       ++i) {
+    if (!hideChecked(i)) {
+      for (--i; i != getVNode(node); --i) {
+        unhide(i);
+      }
+      return false;
+    }
+  }
+
+  horizontalRemove(node);
+  if (learning) {
+    signature ^= item_keys[node - hnodes];
+  }
+  return true;
+}
+
+// Cover the items of node's option other than the one already covered
+bool Dlx::coverOption(VNode *node) {
+  // Once the stamp wraps old stamps could match it, so start over
+  if (++stamp == 0) {
+    std::fill(item_stamp.begin(), item_stamp.end(), 0);
+    stamp = 1;
+  }
+  for (auto j = ++VNode::HorizontalIterator(node); j != node; ++j) {
+    item_stamp[j->top - vnodes] = stamp;
+  }
+  forced = nullptr;
+
+  for (auto j = ++VNode::HorizontalIterator(node); j != node; ++j) {
+    if (!coverChecked(topHNode(j))) {
+      for (--j; j != node; --j) {
+        uncover(topHNode(j));
+      }
+      forced = nullptr;
+      stats.wipeouts++;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Link top's options in the order they appear in column
+void Dlx::relink(VNode *top) {
+  VNode *prev = top;
+  for (VNode *j : column) {
+    prev->down = j;
+    j->up = prev;
+    prev = j;
+  }
+  prev->down = top;
+  top->up = prev;
+}
+
+double Dlx::optionCost(VNode *node) const { return costs[node - vnodes]; }
+
+// Every uncovered item needs an option at least as costly as its cheapest
+// remaining one, and each option can be shared by at most
+// max_option_size items. Lists are sorted by cost so the cheapest is first.
+double Dlx::lowerBound(int max_option_size) {
+  double max_cheapest = 0;
+  double sum_cheapest = 0;
+  for (HNode::HorizontalIterator i(hnodes[0].right); i != hnodes; ++i) {
+    VNode *first = getVNode(i)->down;
+    if (first == getVNode(i)) {
+      continue;
+    }
+    double cheapest = optionCost(first);
+    max_cheapest = std::max(max_cheapest, cheapest);
+    sum_cheapest += cheapest;
+  }
+  return std::max(max_cheapest, sum_cheapest / max_option_size);
+}
+
+// Stable sort every active item's options by cost, so the first option is
+// the cheapest and trying them in order finds good covers early. Only
+// valid while nothing is covered.
+void Dlx::sortOptionsByCost() {
+  for (HNode::HorizontalIterator i(hnodes[0].right); i != hnodes; ++i) {
+    VNode *top = getVNode(i);
+    column.clear();
+    for (auto j = ++VNode::VerticalIterator(top); j != top; ++j) {
+      column.push_back(j);
+    }
+    std::stable_sort(column.begin(), column.end(), [&](VNode *a, VNode *b) {
+      return optionCost(a) < optionCost(b);
+    });
+
+    relink(top);
+  }
+}
+
+// Called as the item chosen at level runs out of options. Its subtree
+// failed if no solution was found since entering the level, and is only
+// worth remembering if it took more than one node to find out.
+void Dlx::learnFailure(int level, std::uint64_t count) {
+  if (level > 0 && count == level_count[level] &&
+      stats.nodes > level_nodes[level]) {
+    nogoods.insert(level_signature[level]);
+    stats.nogoods++;
+  }
+}
+
+// Relink every active item's options in a random order. Only valid while
+// nothing is covered, as the search relies on the order being stable.
+void Dlx::shuffleOptions() {
+  for (HNode::HorizontalIterator i(hnodes[0].right); i != hnodes; ++i) {
+    VNode *top = getVNode(i);
+    column.clear();
+    for (auto j = ++VNode::VerticalIterator(top); j != top; ++j) {
+      column.push_back(j);
+    }
+    std::shuffle(column.begin(), column.end(), rng);
+
+    relink(top);
+  }
+}
+
+// Remember the order restoreOrder puts back
+void Dlx::saveOrder() {
+  original_order.clear();
+  for (HNode::HorizontalIterator i(hnodes[0].right); i != hnodes; ++i) {
+    VNode *top = getVNode(i);
+    for (auto j = ++VNode::VerticalIterator(top); j != top; ++j) {
+      original_order.push_back(j);
+    }
+    original_order.push_back(nullptr);
+  }
+}
+
+// Relink the options saved by saveOrder, once nothing is covered again so
+// the same items are active
+void Dlx::restoreOrder() {
+  if (original_order.empty()) {
+    return;
+  }
+  auto saved = original_order.begin();
+  for (HNode::HorizontalIterator i(hnodes[0].right); i != hnodes; ++i) {
+    column.clear();
+    for (; *saved != nullptr; ++saved) {
+      column.push_back(*saved);
+    }
+    ++saved;
+    relink(getVNode(i));
+  }
+  original_order.clear();
+}
+
+// Undo the first level choices in backtracking, leaving the matrix as the
+// driver built it.
+void Dlx::unwind(int level) {
+  while (level > 0) {
+    level--;
+    VNode *backtrack = backtracking[level];
+    for (auto j = --VNode::HorizontalIterator(backtrack); j != backtrack;
+         --j) {
+      uncover(topHNode(j));
+    }
+    uncover(topHNode(backtrack));
+  }
+}
+
+// Luby's sequence 1 1 2 1 1 2 4 ... gives a restart schedule within a log
+// factor of the optimal one without knowing the runtime distribution.
+static std::uint64_t luby(std::uint64_t i) {
+  for (;;) {
+    std::uint64_t k = 1;
+    while (((std::uint64_t(1) << k) - 1) < i) {
+      k++;
+    }
+    if (i == (std::uint64_t(1) << k) - 1) {
+      return std::uint64_t(1) << (k - 1);
+    }
+    i -= (std::uint64_t(1) << (k - 1)) - 1;
+  }
+}
+
+std::uint64_t Dlx::restartLimit(std::uint64_t run) const {
+  switch (config.restart) {
+  case Restart::None:
+    break;
+  case Restart::Luby:
+    return config.restart_base * luby(run + 1);
+  case Restart::Geometric:
+    return std::min(config.restart_base * std::pow(config.restart_factor, run),
+                    1e18);
+  }
+  return UINT64_MAX;
+}
+
+Dlx::Progress Dlx::snapshot(int level) {
+  Progress snapshot{level, 0, stats.nodes, 0};
+
+  // A covered item's list is left alone by deeper covers, so its size and
+  // order are still those the choice was made from
+  double width = 1;
+  for (int k = 0; k < level; k++) {
+    VNode *top = backtracking[k]->top;
+    int position = 0;
+    for (VNode *j = top->down; j != backtracking[k]; j = j->down) {
+      position++;
+    }
+    width *= top->size;
+    snapshot.explored += position / width;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  double seconds = std::chrono::duration<double>(now - report_time).count();
+  if (seconds > 0) {
+    snapshot.nodes_per_second = (stats.nodes - report_nodes) / seconds;
+  }
+  report_time = now;
+  report_nodes = stats.nodes;
+  return snapshot;
+}
+
+// Data TLB read misses of the calling thread, zero where perf events are
+// not permitted
+struct TlbCounter {
+  int fd;
+
+  TlbCounter() {
+    perf_event_attr attr{};
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+
+  ~TlbCounter() {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+
+  std::uint64_t read() const {
+    std::uint64_t count = 0;
+    if (fd < 0 || ::read(fd, &count, sizeof(count)) != sizeof(count)) {
+      return 0;
+    }
+    return count;
+  }
+};
+
+static std::uint64_t pageFaults() {
+  rusage usage;
+  getrusage(RUSAGE_THREAD, &usage);
+  return usage.ru_minflt + usage.ru_majflt;
+}
+
+std::uint64_t Dlx::solveAll(Dlx::Driver *driver, const Visit &visit) {
+  if (!config.measure_memory) {
+    std::uint64_t count = search(driver, visit);
+    stats.page_size = driver->page_size;
+    stats.pages = driver->pages;
+    return count;
+  }
+
+  static thread_local TlbCounter tlb;
+  std::uint64_t faults = pageFaults();
+  std::uint64_t misses = tlb.read();
+
+  std::uint64_t count = search(driver, visit);
+
+  stats.page_size = driver->page_size;
+  stats.pages = driver->pages;
+  stats.page_faults = pageFaults() - faults;
+  stats.tlb_misses = tlb.read() - misses;
+  return count;
+}
+
+std::uint64_t Dlx::search(Dlx::Driver *driver, const Visit &visit) {
+  DLX_TRACE_SPAN("solve");
+  DLX_TRACE_START(trace_begin);
   hnodes = driver->hnodes;
   vnodes = driver->vnodes;
+  costs = driver->costs;
+
+  stats = {};
+  rng.seed(config.seed);
+  original_order.clear();
+  if (config.randomize || config.minimize) {
+    saveOrder();
+  }
+  if (config.randomize) {
+    shuffleOptions();
+  }
+
+  int max_option_size = 1;
+  if (config.minimize) {
+    sortOptionsByCost();
+    int option_size = 0;
+    for (int i = driver->hnodes_size; i < driver->vnodes_size; i++) {
+      option_size = vnodes[i].top == nullptr ? 0 : option_size + 1;
+      max_option_size = std::max(max_option_size, option_size);
+    }
+  }
 
-  std::vector<VNode *> backtracking;
   backtracking.resize(driver->solution_size);
+  level_cost.resize(driver->solution_size + 1);
+  level_cost[0] = 0;
+  best = std::numeric_limits<double>::infinity();
+
+  learning = config.learn && !config.minimize;
+  if (learning) {
+    nogoods.reserve(config.learn_memory);
+    item_keys.resize(driver->hnodes_size);
+    for (Signature &i : item_keys) {
+      i = {key_rng(), key_rng()};
+    }
+    signature = {0, 0};
+    level_signature.resize(driver->solution_size + 1);
+    level_count.resize(driver->solution_size + 1);
+    level_nodes.resize(driver->solution_size + 1);
+  }
+
+  if (config.forward_check) {
+    item_stamp.assign(driver->hnodes_size, 0);
+    stamp = 0;
+  }
+  forced = nullptr;
+
+  prepareWeights(driver);
+
+  report_time = std::chrono::steady_clock::now();
+  report_nodes = 0;
+  DLX_TRACE_STOP(trace_begin, "setup", 0);
+
+  std::uint64_t count = 0;
+  std::uint64_t run_nodes = 0;
+  std::uint64_t run_limit = restartLimit(0);
 
   int level = 0;
-  for (HNode *i = selectItem(); i != hnodes; i = selectItem()) {
-    cover(i);
+  DLX_TRACE_RESTART(trace_begin);
+  for (;;) {
+    HNode *i = selectItem();
+    VNode *backtrack;
 
-    backtracking[level] = getVNode(i)->down;
-    VNode *backtrack = backtracking[level];
+    bool failed = false;
+    if (i != hnodes && config.minimize &&
+        level_cost[level] + lowerBound(max_option_size) >= best) {
+      stats.pruned++;
+      failed = true;
+    } else if (i != hnodes && learning && level > 0) {
+      failed = nogoods.contains(signature);
+      failed ? stats.nogood_hits++ : stats.nogood_misses++;
+    }
 
-    // Backtrack until our current item has options left
-    while (backtrack == getVNode(i)) {
-      uncover(i);
+    if (i == hnodes || failed) {
+      if (i == hnodes) {
+        count++;
+        best = level_cost[level];
+        if (!visit({backtracking.data(), std::size_t(level)})) {
+          vnodes = nullptr;
+          hnodes = nullptr;
+          return count;
+        }
+      }
 
       if (level == 0) {
+        restoreOrder();
         vnodes = nullptr;
         hnodes = nullptr;
-        return {};
+        return count;
       }
 
+      // Resume from the deepest choice as if it had failed
       level--;
       backtrack = backtracking[level];
       for (auto j = --VNode::HorizontalIterator(backtrack); j != backtrack;
@@ -108,17 +558,211 @@ std::vector<Dlx::VNode *> Dlx::solve(Dlx::Driver *driver) {
       i = topHNode(backtrack);
       backtracking[level] = backtrack->down;
       backtrack = backtracking[level];
+    } else {
+      if (cancel != nullptr && cancel->load(std::memory_order_relaxed)) {
+        unwind(level);
+        restoreOrder();
+        vnodes = nullptr;
+        hnodes = nullptr;
+        return count;
+      }
+
+      if (report != nullptr && report->load(std::memory_order_relaxed)) {
+        report->store(false, std::memory_order_relaxed);
+        if (progress) {
+          progress(snapshot(level));
+        }
+      }
+
+      // Restarting after a solution was visited would visit it again
+      if (run_nodes >= run_limit && count == 0) {
+        DLX_TRACE_STOP(trace_begin, "run", run_nodes);
+        DLX_TRACE_RESTART(trace_begin);
+        unwind(level);
+        level = 0;
+        forced = nullptr;
+        stats.restarts++;
+        run_nodes = 0;
+        run_limit = restartLimit(stats.restarts);
+        if (config.randomize) {
+          shuffleOptions();
+        }
+        if (config.minimize) {
+          sortOptionsByCost();
+        }
+        continue;
+      }
+
+      if (learning) {
+        level_signature[level] = signature;
+        level_count[level] = count;
+        level_nodes[level] = stats.nodes;
+      }
+
+      cover(i);
+
+      backtracking[level] = getVNode(i)->down;
+      backtrack = backtracking[level];
+    }
+
+    // Backtrack until our current item has options left. When minimizing
+    // the options are sorted, so once one is too costly the rest are too.
+    // When forward checking, options that wipe out an item are skipped.
+#ifdef DLX_TRACE
+    int pops = 0;
+    std::uint64_t pops_begin = 0;
+#endif
+    for (;;) {
+      while (backtrack == getVNode(i) ||
+             (config.minimize &&
+              level_cost[level] + optionCost(backtrack) >= best)) {
+        if (config.weighted && backtrack == getVNode(i)) {
+          bumpWeight(i);
+        }
+        uncover(i);
+        if (learning) {
+          learnFailure(level, count);
+        }
+
+        if (level == 0) {
+          restoreOrder();
+          vnodes = nullptr;
+          hnodes = nullptr;
+          return count;
+        }
+
+#ifdef DLX_TRACE
+        if (pops++ == 0) {
+          pops_begin = Trace::now();
+        }
+#endif
+        level--;
+        backtrack = backtracking[level];
+        for (auto j = --VNode::HorizontalIterator(backtrack); j != backtrack;
+             --j) {
+          uncover(topHNode(j));
+        }
+
+        i = topHNode(backtrack);
+        backtracking[level] = backtrack->down;
+        backtrack = backtracking[level];
+      }
+
+      if (!config.forward_check) {
+        for (auto j = ++VNode::HorizontalIterator(backtrack); j != backtrack;
+             ++j) {
+          cover(topHNode(j));
+        }
+        break;
+      }
+      if (coverOption(backtrack)) {
+        break;
+      }
+      backtracking[level] = backtrack->down;
+      backtrack = backtracking[level];
+    }
+#ifdef DLX_TRACE
+    if (pops >= Trace::burst_min) {
+      Trace::record("backtrack", pops_begin, Trace::now(), pops);
     }
+#endif
 
-    for (auto j = ++VNode::HorizontalIterator(backtrack); j != backtrack; ++j) {
-      cover(topHNode(j));
+    if (config.minimize) {
+      level_cost[level + 1] = level_cost[level] + optionCost(backtrack);
     }
 
+    stats.nodes++;
+    run_nodes++;
     level++;
   }
+}
+
+std::vector<Dlx::VNode *> Dlx::solve(Dlx::Driver *driver) {
+  std::vector<VNode *> solution;
+  solveAll(driver, [&](std::span<VNode *const> found) {
+    solution.assign(found.begin(), found.end());
+    return false;
+  });
+  return solution;
+}
+
+// Each probe follows one random path, and at each level multiplies the
+// width of the tree by the number of options the chosen item had. The sum
+// of widths is an unbiased estimate of the nodes in the tree, as is the
+// width at a solution of the number of solutions.
+Dlx::Estimate Dlx::estimate(Dlx::Driver *driver, int probes) {
+  DLX_TRACE_SPAN("estimate");
+  hnodes = driver->hnodes;
+  vnodes = driver->vnodes;
+
+  learning = false;
+  forced = nullptr;
+  prepareWeights(driver);
+  backtracking.resize(driver->solution_size);
+  rng.seed(config.seed);
+
+  Estimate estimate;
+  std::uint64_t walked = 0;
+  auto start = std::chrono::steady_clock::now();
+
+  for (int probe = 0; probe < probes; probe++) {
+    double width = 1;
+    int level = 0;
+    for (;;) {
+      HNode *i = selectItem();
+      if (i == hnodes) {
+        estimate.solutions += width;
+        break;
+      }
+
+      int options = size(i);
+      if (options == 0) {
+        break;
+      }
+      width *= options;
+      estimate.nodes += width;
+
+      VNode *choice = getVNode(i)->down;
+      for (auto k = rng() % options; k > 0; k--) {
+        choice = choice->down;
+      }
+
+      cover(i);
+      for (auto j = ++VNode::HorizontalIterator(choice); j != choice; ++j) {
+        cover(topHNode(j));
+      }
+      backtracking[level] = choice;
+      level++;
+      walked++;
+    }
+    unwind(level);
+  }
+
+  double seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  if (probes > 0) {
+    estimate.nodes /= probes;
+    estimate.solutions /= probes;
+  }
+  if (walked > 0) {
+    estimate.seconds = estimate.nodes * seconds / walked;
+  }
+
+  vnodes = nullptr;
+  hnodes = nullptr;
+  return estimate;
+}
+
+std::vector<Dlx::VNode *> Dlx::solveMinCost(Dlx::Driver *driver) {
+  bool minimize = config.minimize;
+  config.minimize = true;
+
+  std::vector<VNode *> solution;
+  solveAll(driver, [&](std::span<VNode *const> found) {
+    solution.assign(found.begin(), found.end());
+    return true;
+  });
 
-  backtracking.resize(level);
-  vnodes = NULL;
-  hnodes = NULL;
-  return backtracking;
+  config.minimize = minimize;
+  return solution;
 }
@@ -47,6 +47,14 @@
  */
 
 #pragma once
+#include "dlx_nogood.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <span>
 #include <vector>
 
 struct Dlx {
@@ -236,11 +244,152 @@ struct Dlx {
     HNode *hnodes;
     VNode *vnodes;
 
+    // Number of nodes in each array, needed to copy the matrix
+    int hnodes_size;
+    int vnodes_size;
+
     int solution_size;
+
+    // Optional cost of each option, indexed like vnodes with every node of
+    // an option holding the option's cost. Only read when minimizing, and
+    // must be finite and not negative as the pruning bounds rely on it.
+    double *costs = nullptr;
+
+    // Pages backing the nodes if the driver knows, copied into the stats
+    std::size_t page_size = 0;
+    std::size_t pages = 0;
+  };
+
+  enum class Restart { None, Luby, Geometric };
+
+  // Search configuration. Restarts only make sense with randomize set,
+  // otherwise every run retraces the same tree.
+  struct Config {
+    bool randomize = false;
+    std::uint64_t seed = 0;
+
+    Restart restart = Restart::None;
+    // Nodes allowed in the first run, scaled by the schedule after that
+    std::uint64_t restart_base = 1000;
+    double restart_factor = 1.5;
+
+    // Branch and bound for the cheapest cover, needs the driver's costs
+    bool minimize = false;
+
+    // Remember subproblems proven unsolvable, see dlx_nogood.h. Ignored
+    // when minimizing since pruned subtrees are not proven unsolvable.
+    bool learn = false;
+    std::size_t learn_memory = std::size_t(1) << 24;
+
+    // Abandon an option as soon as covering it leaves some other item with
+    // no options, undoing only the covering done so far, and branch next on
+    // an item the option left with one option without scanning for it
+    bool forward_check = false;
+
+    // Branch on the item with the fewest options per unit of weight. An
+    // item gains weight each time the search runs out of options for it,
+    // and each gain is 1 / weight_decay times the one before so recent
+    // dead ends count most. With forward_check the item an option wiped
+    // out gains weight too.
+    bool weighted = false;
+    double weight_decay = 0.95;
+
+    // Count the thread's page faults and, where perf events are permitted,
+    // data TLB misses over each solve
+    bool measure_memory = false;
+  };
+
+  struct Stats {
+    std::uint64_t nodes = 0;
+    std::uint64_t restarts = 0;
+    std::uint64_t pruned = 0;
+
+    std::uint64_t nogood_hits = 0;
+    std::uint64_t nogood_misses = 0;
+    std::uint64_t nogoods = 0;
+
+    // Options abandoned part way through covering, and items chosen
+    // because an option forced them
+    std::uint64_t wipeouts = 0;
+    std::uint64_t forced = 0;
+
+    std::size_t page_size = 0;
+    std::size_t pages = 0;
+    std::uint64_t page_faults = 0;
+    std::uint64_t tlb_misses = 0;
+  };
+
+  // Knuth's estimate of the search tree from random probes, averaged
+  struct Estimate {
+    double nodes = 0;
+    double solutions = 0;
+    double seconds = 0;
+  };
+
+  // Snapshot of a running search. Explored is the fraction of the tree
+  // behind the current path, judged by each level's position among its
+  // item's options, and nodes_per_second is since the last snapshot.
+  struct Progress {
+    int level;
+    double explored;
+    std::uint64_t nodes;
+    double nodes_per_second;
   };
 
   HNode *hnodes;
   VNode *vnodes;
+  double *costs;
+
+  Config config;
+  Stats stats;
+  std::mt19937_64 rng;
+
+  // Set by another thread to abandon the search, solve then returns {}
+  const std::atomic<bool> *cancel = nullptr;
+
+  // Set by a timer or signal handler to have the search pass a snapshot to
+  // progress at its next node, after which it is cleared
+  std::atomic<bool> *report = nullptr;
+  std::function<void(const Progress &)> progress;
+  std::chrono::steady_clock::time_point report_time;
+  std::uint64_t report_nodes;
+
+  // Scratch space kept between solves so repeated solves do not allocate
+  std::vector<VNode *> backtracking;
+  std::vector<VNode *> column;
+  // Each active item's options in the driver's order, separated by nullptr,
+  // saved before randomizing or sorting relinks them
+  std::vector<VNode *> original_order;
+
+  // Cost of the incumbent cover when minimizing, and of the choices made
+  // above each level
+  double best;
+  std::vector<double> level_cost;
+
+  // Signature of the covered items and key of each item when learning.
+  // Each level remembers its signature, and the solution and node counts
+  // on entry to tell whether its subtree failed.
+  bool learning = false;
+  NogoodTable nogoods;
+  std::mt19937_64 key_rng;
+  std::vector<Signature> item_keys;
+  Signature signature;
+  std::vector<Signature> level_signature;
+  std::vector<std::uint64_t> level_count;
+  std::vector<std::uint64_t> level_nodes;
+
+  // Items of the option being covered carry the current stamp, as their
+  // sizes may reach zero. Forced is the last other item left with one
+  // option, a ready choice for selectItem if still uncovered.
+  std::vector<std::uint32_t> item_stamp;
+  std::uint32_t stamp = 0;
+  HNode *forced = nullptr;
+
+  // Weight of each item when weighted, and the current gain. Weights carry
+  // over restarts and later solves of problems with as many items, as batch
+  // instances of one family have. Clear item_weights to forget them.
+  std::vector<double> item_weights;
+  double weight_gain = 1;
 
   VNode *getVNode(HNode *node);
   HNode *getHNode(VNode *node);
@@ -254,11 +403,52 @@ struct Dlx {
   void horizontalRemove(HNode *node);
 
   HNode *selectItem();
+  HNode *selectWeightedItem();
+  void prepareWeights(Driver *driver);
+  void bumpWeight(HNode *node);
 
   void hide(VNode *node);
   void unhide(VNode *node);
   void cover(HNode *node);
   void uncover(HNode *node);
 
+  // Forward checking versions, false if some unstamped item ran out of
+  // options, in which case whatever was done has been undone
+  bool hideChecked(VNode *node);
+  bool coverChecked(HNode *node);
+  bool coverOption(VNode *node);
+
+  void relink(VNode *top);
+  double optionCost(VNode *node) const;
+  double lowerBound(int max_option_size);
+  void sortOptionsByCost();
+
+  void learnFailure(int level, std::uint64_t count);
+
+  void shuffleOptions();
+  void saveOrder();
+  void restoreOrder();
+  void unwind(int level);
+  std::uint64_t restartLimit(std::uint64_t run) const;
+  Progress snapshot(int level);
+
+  // Called with each solution found, returns whether to keep searching
+  using Visit = std::function<bool(std::span<VNode *const>)>;
+
+  // Visit solutions until visit returns false or the search is exhausted,
+  // in which case the driver's matrix is left as it was built, with options
+  // back in their original order after randomizing or minimizing. Returns the
+  // number of solutions visited. When minimizing only solutions cheaper
+  // than every one before are visited, so the last is the cheapest.
+  std::uint64_t solveAll(Driver *driver, const Visit &visit);
+  // The search behind solveAll, which adds the memory stats
+  std::uint64_t search(Driver *driver, const Visit &visit);
   std::vector<VNode *> solve(Driver *driver);
+
+  // Walk probes random paths from the root, leaving the matrix as built.
+  // The runtime is the estimated nodes at the rate the probes ran.
+  Estimate estimate(Driver *driver, int probes);
+
+  // The cheapest cover, its cost is left in best
+  std::vector<VNode *> solveMinCost(Driver *driver);
 };
@@ -0,0 +1,157 @@
+#include "dlx_arena.h"
+#include "dlx_trace.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static constexpr std::size_t huge_2m = std::size_t(1) << 21;
+static constexpr std::size_t huge_1g = std::size_t(1) << 30;
+
+// From linux/mempolicy.h, which needs libnuma headers on some systems
+static constexpr int mpol_bind = 2;
+
+static std::size_t roundUp(std::size_t size, std::size_t page) {
+  return (size + page - 1) / page * page;
+}
+
+static void *mapPages(std::size_t length, int flags) {
+  void *block = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+  return block == MAP_FAILED ? nullptr : block;
+}
+
+NodeArena::~NodeArena() { release(); }
+
+void NodeArena::reserve(int hnodes_size, int vnodes_size) {
+  size = hnodes_size * sizeof(Dlx::HNode) + vnodes_size * sizeof(Dlx::VNode);
+  if (size > capacity || !(config == mapped)) {
+    release();
+    allocate(size);
+  }
+  hnodes = reinterpret_cast<Dlx::HNode *>(data);
+  vnodes = reinterpret_cast<Dlx::VNode *>(data +
+                                          hnodes_size * sizeof(Dlx::HNode));
+}
+
+void NodeArena::allocate(std::size_t size) {
+  size = std::max<std::size_t>(size, 1);
+  std::size_t normal = sysconf(_SC_PAGESIZE);
+  stats = {};
+  void *block = nullptr;
+  std::size_t length = 0;
+
+  // Try the configured page size, then each smaller one
+  switch (config.pages) {
+  case Pages::Huge1G:
+    length = roundUp(size, huge_1g);
+    block = mapPages(length, MAP_HUGETLB | (30 << MAP_HUGE_SHIFT));
+    if (block != nullptr) {
+      stats.page_size = huge_1g;
+      break;
+    }
+    [[fallthrough]];
+  case Pages::Huge2M:
+    length = roundUp(size, huge_2m);
+    block = mapPages(length, MAP_HUGETLB | (21 << MAP_HUGE_SHIFT));
+    if (block != nullptr) {
+      stats.page_size = huge_2m;
+      break;
+    }
+    [[fallthrough]];
+  case Pages::Transparent:
+    length = roundUp(size, huge_2m);
+    block = mapPages(length, 0);
+    if (block != nullptr) {
+      // Only advice, the kernel may still use normal pages
+      stats.transparent = madvise(block, length, MADV_HUGEPAGE) == 0;
+      stats.page_size = normal;
+      break;
+    }
+    [[fallthrough]];
+  case Pages::Normal:
+    length = roundUp(size, normal);
+    block = mapPages(length, 0);
+    stats.page_size = normal;
+  }
+
+  if (block == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  // Binding has to happen before the pages are first touched
+  int node = config.numa_node;
+  if (node == local_node) {
+    unsigned cpu, local;
+    node = syscall(SYS_getcpu, &cpu, &local, nullptr) == 0 ? local : -1;
+  }
+  if (node >= 0 && node < 64) {
+    unsigned long mask = 1ul << node;
+    if (syscall(SYS_mbind, block, length, mpol_bind, &mask, 64, 0) == 0) {
+      stats.numa_node = node;
+    }
+  }
+
+  data = static_cast<std::byte *>(block);
+  capacity = length;
+  mapped = config;
+  stats.pages = length / stats.page_size;
+
+  if (config.prefault) {
+    auto *touch = static_cast<volatile std::byte *>(data);
+    for (std::size_t i = 0; i < length; i += stats.page_size) {
+      touch[i] = std::byte(0);
+    }
+  }
+}
+
+void NodeArena::release() {
+  if (data != nullptr) {
+    munmap(data, capacity);
+  }
+  data = nullptr;
+  capacity = 0;
+}
+
+template <typename T> static T *rebase(T *node, T *from, T *to, int size) {
+  auto p = reinterpret_cast<std::uintptr_t>(node);
+  auto begin = reinterpret_cast<std::uintptr_t>(from);
+  // Spacers at the ends may point outside the array, those are never
+  // followed
+  if (p < begin || p >= begin + size * sizeof(T)) {
+    return nullptr;
+  }
+  return to + (node - from);
+}
+
+void NodeArena::assign(const Dlx::Driver *driver) {
+  DLX_TRACE_SPAN("arena assign");
+  reserve(driver->hnodes_size, driver->vnodes_size);
+
+  for (int i = 0; i < driver->hnodes_size; i++) {
+    const Dlx::HNode &node = driver->hnodes[i];
+    hnodes[i].left =
+        rebase(node.left, driver->hnodes, hnodes, driver->hnodes_size);
+    hnodes[i].right =
+        rebase(node.right, driver->hnodes, hnodes, driver->hnodes_size);
+  }
+
+  for (int i = 0; i < driver->vnodes_size; i++) {
+    const Dlx::VNode &node = driver->vnodes[i];
+    Dlx::VNode &copy = vnodes[i];
+    copy.up = rebase(node.up, driver->vnodes, vnodes, driver->vnodes_size);
+    copy.down =
+        rebase(node.down, driver->vnodes, vnodes, driver->vnodes_size);
+    // Item headers hold a size instead of top
+    if (i < driver->hnodes_size) {
+      copy.top = nullptr;
+      copy.size = node.size;
+    } else {
+      copy.top =
+          rebase(node.top, driver->vnodes, vnodes, driver->vnodes_size);
+    }
+  }
+}
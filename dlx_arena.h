@@ -0,0 +1,75 @@
+/*
+ * Node arenas
+ *
+ * Searching a large matrix follows links all over it, so on multi-GB
+ * matrices nearly every hide and unhide misses the TLB when the nodes
+ * sit on 4KB pages. An arena keeps a driver's hnodes followed by its
+ * vnodes in one block mapped straight from the kernel, which can be
+ * backed by 2MB or 1GB huge pages so the whole matrix needs a handful of
+ * TLB entries.
+ *
+ * Explicit huge pages need pages reserved by the administrator, so when
+ * a mapping fails the arena falls back to the next smaller size, ending
+ * with transparent huge pages and then normal pages. Stats records what
+ * was actually used.
+ *
+ * The block can be bound to a NUMA node, or to the node of the thread
+ * allocating it so each worker's copy is local, and prefaulted so the
+ * search does not take page faults as it first touches the matrix.
+ */
+
+#pragma once
+#include "dlx.h"
+
+#include <cstddef>
+
+struct NodeArena {
+  enum class Pages { Normal, Transparent, Huge2M, Huge1G };
+
+  // Bind to the node of the thread that allocates
+  static constexpr int local_node = -2;
+
+  struct Config {
+    Pages pages = Pages::Normal;
+    bool prefault = false;
+    // Node to bind to, local_node, or -1 to leave placement to the kernel
+    int numa_node = -1;
+
+    bool operator==(const Config &) const = default;
+  };
+
+  struct Stats {
+    std::size_t page_size = 0;
+    std::size_t pages = 0;
+    bool transparent = false;
+    // Node the block was bound to, -1 if it was not
+    int numa_node = -1;
+  };
+
+  Config config;
+  Stats stats;
+
+  std::byte *data = nullptr;
+  std::size_t capacity = 0;
+  std::size_t size = 0;
+  // Config the block was mapped with
+  Config mapped;
+
+  Dlx::HNode *hnodes;
+  Dlx::VNode *vnodes;
+
+  NodeArena() = default;
+  NodeArena(const NodeArena &) = delete;
+  NodeArena &operator=(const NodeArena &) = delete;
+  ~NodeArena();
+
+  // Only reallocates when growing or when config changed
+  void reserve(int hnodes_size, int vnodes_size);
+
+  // Copy the driver's matrix in, rebasing its links. Links that pointed
+  // outside the driver's arrays become null.
+  void assign(const Dlx::Driver *driver);
+
+  void allocate(std::size_t size);
+  void release();
+};
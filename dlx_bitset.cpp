@@ -0,0 +1,273 @@
+#include "dlx_bitset.h"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+static int selectScalar(const std::uint16_t *counts, int size) {
+  int min_c = 0;
+  std::uint16_t min_value = counts[0];
+  for (int c = 1; c < size; c++) {
+    if (counts[c] < min_value) {
+      min_value = counts[c];
+      min_c = c;
+    }
+  }
+  return min_c;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("avx2"))) static int
+selectAvx2(const std::uint16_t *counts, int size) {
+  __m256i min = _mm256_set1_epi16(-1);
+  for (int i = 0; i < size; i += 16) {
+    min = _mm256_min_epu16(
+        min, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(counts + i)));
+  }
+  __m128i half = _mm_min_epu16(_mm256_castsi256_si128(min),
+                               _mm256_extracti128_si256(min, 1));
+  __m256i value = _mm256_set1_epi16(_mm_extract_epi16(_mm_minpos_epu16(half), 0));
+
+  for (int i = 0;; i += 16) {
+    __m256i equal = _mm256_cmpeq_epi16(
+        value,
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(counts + i)));
+    unsigned mask = _mm256_movemask_epi8(equal);
+    if (mask != 0) {
+      return i + std::countr_zero(mask) / 2;
+    }
+  }
+}
+
+__attribute__((target("avx512f,avx512bw"))) static int
+selectAvx512(const std::uint16_t *counts, int size) {
+  __m512i min = _mm512_set1_epi16(-1);
+  for (int i = 0; i < size; i += 32) {
+    min = _mm512_min_epu16(min, _mm512_loadu_si512(counts + i));
+  }
+  // The masked extracts take a defined passthrough, the plain ones leave it
+  // uninitialized and GCC warns
+  __m256i zero = _mm256_setzero_si256();
+  __m256i quarter =
+      _mm256_min_epu16(_mm512_mask_extracti64x4_epi64(zero, 0xf, min, 0),
+                       _mm512_mask_extracti64x4_epi64(zero, 0xf, min, 1));
+  __m128i half = _mm_min_epu16(_mm256_castsi256_si128(quarter),
+                               _mm256_extracti128_si256(quarter, 1));
+  __m512i value =
+      _mm512_set1_epi16(_mm_extract_epi16(_mm_minpos_epu16(half), 0));
+
+  for (int i = 0;; i += 32) {
+    __mmask32 equal =
+        _mm512_cmpeq_epi16_mask(value, _mm512_loadu_si512(counts + i));
+    if (equal != 0) {
+      return i + std::countr_zero(equal);
+    }
+  }
+}
+
+#endif
+
+std::vector<BitsetDlx::Kernel> BitsetDlx::kernels() {
+  std::vector<Kernel> supported = {{selectScalar, "scalar"}};
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    supported.push_back({selectAvx2, "avx2"});
+  }
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+    supported.push_back({selectAvx512, "avx512"});
+  }
+#endif
+  return supported;
+}
+
+static const BitsetDlx::Kernel kernel = BitsetDlx::kernels().back();
+
+const char *BitsetDlx::kernel() { return ::kernel.name; }
+
+bool BitsetDlx::generate(Dlx::Driver *driver) {
+  Dlx::HNode *hnodes = driver->hnodes;
+  Dlx::VNode *vnodes = driver->vnodes;
+
+  // Index of each active item, by the driver's header index
+  std::vector<int> item_index(driver->hnodes_size, -1);
+  item_count = 0;
+  for (Dlx::HNode::HorizontalIterator i(hnodes[0].right); i != hnodes; ++i) {
+    item_index[&*i - hnodes] = item_count++;
+  }
+
+  // Collect options from the active items' lists rather than the spacers,
+  // so options a driver has unlinked, as symmetry removal does, are left
+  // out. Sorting keeps them in the order they were built.
+  std::vector<char> seen(driver->vnodes_size);
+  std::vector<int> spacers;
+  for (Dlx::HNode::HorizontalIterator i(hnodes[0].right); i != hnodes; ++i) {
+    Dlx::VNode *top = &vnodes[&*i - hnodes];
+    for (auto j = ++Dlx::VNode::VerticalIterator(top); j != top; ++j) {
+      Dlx::VNode *spacer = &*j;
+      while (spacer->top != nullptr) {
+        spacer--;
+      }
+      if (!seen[spacer - vnodes]) {
+        seen[spacer - vnodes] = true;
+        spacers.push_back(spacer - vnodes);
+      }
+    }
+  }
+  std::sort(spacers.begin(), spacers.end());
+
+  option_source.clear();
+  for (int spacer : spacers) {
+    option_source.push_back(&vnodes[spacer + 1]);
+  }
+  option_count = option_source.size();
+
+  if (item_count > max_items || option_count > max_options) {
+    return false;
+  }
+
+  words = (option_count + 63) / 64;
+  item_options.assign(std::size_t(item_count) * words, 0);
+  option_begin.clear();
+  option_item.clear();
+
+  for (int o = 0; o < option_count; o++) {
+    option_begin.push_back(option_item.size());
+    Dlx::VNode::HorizontalIterator j(option_source[o]);
+    do {
+      int c = item_index[j->top - vnodes];
+      if (c != -1) {
+        option_item.push_back(c);
+        item_options[std::size_t(c) * words + o / 64] |= std::uint64_t(1)
+                                                         << (o % 64);
+      }
+    } while (++j != option_source[o]);
+  }
+  option_begin.push_back(option_item.size());
+  return true;
+}
+
+int BitsetDlx::selectItem(const Counts &counts) const {
+  int c = ::kernel.select(counts.data(), item_count);
+  return counts[c] == inactive ? -1 : c;
+}
+
+std::uint64_t BitsetDlx::solveAll(Dlx::Driver *driver,
+                                  const Dlx::Visit &visit) {
+  if (!generate(driver)) {
+    Dlx dlx;
+    std::uint64_t count = dlx.solveAll(driver, visit);
+    stats = dlx.stats;
+    return count;
+  }
+  stats = {};
+
+  // Per level state, each level derives its own from the one above
+  std::vector<Counts> counts(item_count + 1);
+  std::vector<std::uint64_t> live(std::size_t(item_count + 1) * words);
+  std::vector<std::uint64_t> candidates(std::size_t(item_count + 1) * words);
+  std::vector<Dlx::VNode *> solution(item_count);
+
+  counts[0].fill(inactive);
+  for (int c = 0; c < item_count; c++) {
+    counts[0][c] = 0;
+  }
+  for (int o = 0; o < option_count; o++) {
+    live[o / 64] |= std::uint64_t(1) << (o % 64);
+    for (int k = option_begin[o]; k < option_begin[o + 1]; k++) {
+      counts[0][option_item[k]]++;
+    }
+  }
+
+  // Without options words is 0 and the vectors are empty, so the per level
+  // slices are taken from data() rather than by indexing
+  std::uint64_t count = 0;
+  int level = 0;
+  for (;;) {
+    std::uint64_t *level_live = live.data() + std::size_t(level) * words;
+    std::uint64_t *level_candidates =
+        candidates.data() + std::size_t(level) * words;
+
+    int c = selectItem(counts[level]);
+    if (c == -1) {
+      count++;
+      if (!visit({solution.data(), std::size_t(level)})) {
+        return count;
+      }
+      std::fill(level_candidates, level_candidates + words, 0);
+    } else {
+      const std::uint64_t *column =
+          item_options.data() + std::size_t(c) * words;
+      for (int w = 0; w < words; w++) {
+        level_candidates[w] = column[w] & level_live[w];
+      }
+    }
+
+    // Backtrack until some level has candidates left
+    int w = 0;
+    for (;;) {
+      level_candidates = candidates.data() + std::size_t(level) * words;
+      while (w < words && level_candidates[w] == 0) {
+        w++;
+      }
+      if (w < words) {
+        break;
+      }
+      if (level == 0) {
+        return count;
+      }
+      level--;
+      w = 0;
+    }
+
+    int o = w * 64 + std::countr_zero(level_candidates[w]);
+    level_candidates[w] &= level_candidates[w] - 1;
+    solution[level] = option_source[o];
+
+    // Drop every option sharing an item with o, o included
+    const std::uint64_t *parent_live = live.data() + std::size_t(level) * words;
+    std::uint64_t *child_live = live.data() + std::size_t(level + 1) * words;
+    std::copy(parent_live, parent_live + words, child_live);
+    for (int k = option_begin[o]; k < option_begin[o + 1]; k++) {
+      const std::uint64_t *column =
+          item_options.data() + std::size_t(option_item[k]) * words;
+      for (int i = 0; i < words; i++) {
+        child_live[i] &= ~column[i];
+      }
+    }
+
+    // Live options only contain active items, so the dropped ones can
+    // decrement without checking, then o's items are covered
+    Counts &child_counts = counts[level + 1];
+    child_counts = counts[level];
+    for (int i = 0; i < words; i++) {
+      for (std::uint64_t bits = parent_live[i] & ~child_live[i]; bits != 0;
+           bits &= bits - 1) {
+        int dropped = i * 64 + std::countr_zero(bits);
+        for (int k = option_begin[dropped]; k < option_begin[dropped + 1];
+             k++) {
+          child_counts[option_item[k]]--;
+        }
+      }
+    }
+    for (int k = option_begin[o]; k < option_begin[o + 1]; k++) {
+      child_counts[option_item[k]] = inactive;
+    }
+
+    stats.nodes++;
+    level++;
+  }
+}
+
+std::vector<Dlx::VNode *> BitsetDlx::solve(Dlx::Driver *driver) {
+  std::vector<Dlx::VNode *> solution;
+  solveAll(driver, [&](std::span<Dlx::VNode *const> found) {
+    solution.assign(found.begin(), found.end());
+    return false;
+  });
+  return solution;
+}
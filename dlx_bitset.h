@@ -0,0 +1,78 @@
+/*
+ * Bitset exact cover solver for small problems
+ *
+ * When there are only a few hundred items and a few thousand options the
+ * whole search state fits in a few cache lines, and walking linked lists
+ * costs more than recomputing things with wide bitwise operations.
+ *
+ * Each item keeps the set of options containing it as a bitset over the
+ * options, and each level of the search keeps the set of options still
+ * compatible with the choices so far. Choosing an option clears the
+ * bitsets of each of its items from the live options, and the options
+ * that disappeared decrement the option counts of their items. Each level
+ * owns its copy of both so backtracking costs nothing.
+ *
+ * Picking the item with the fewest options is then a minimum over a small
+ * array of counts, done with AVX-512, AVX2 or a scalar loop depending on
+ * what the CPU supports at runtime.
+ *
+ * Like DancingCells this reads the matrix of any Dlx::Driver without
+ * changing it, and falls back to Dlx when the problem is too big.
+ */
+
+#pragma once
+#include "dlx.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+struct BitsetDlx {
+  static constexpr int max_items = 512;
+  static constexpr int max_options = 4096;
+
+  // Options left for each item, covered items hold inactive so they are
+  // never the minimum
+  static constexpr std::uint16_t inactive = 0xffff;
+  using Counts = std::array<std::uint16_t, max_items>;
+
+  int item_count;
+  int option_count;
+  // 64 bit words in a bitset over the options
+  int words;
+
+  // Options of each item with words entries per item
+  std::vector<std::uint64_t> item_options;
+
+  // Items of option o are option_item[option_begin[o]] up to the next
+  std::vector<int> option_begin;
+  std::vector<int> option_item;
+
+  // First node of each option in the driver's matrix
+  std::vector<Dlx::VNode *> option_source;
+
+  Dlx::Stats stats;
+
+  // Returns false if the driver's matrix is too big for the bitsets
+  bool generate(Dlx::Driver *driver);
+
+  // Returns -1 once every item is covered
+  int selectItem(const Counts &counts) const;
+
+  std::uint64_t solveAll(Dlx::Driver *driver, const Dlx::Visit &visit);
+  std::vector<Dlx::VNode *> solve(Dlx::Driver *driver);
+
+  // Name of the selection kernel in use
+  static const char *kernel();
+
+  // Index of the first smallest count among the first size. The vector
+  // kernels read on up to the next multiple of 32, which must be inactive.
+  using Select = int (*)(const std::uint16_t *counts, int size);
+  struct Kernel {
+    Select select;
+    const char *name;
+  };
+
+  // Kernels the CPU supports from scalar to widest, the last is used
+  static std::vector<Kernel> kernels();
+};
@@ -0,0 +1,142 @@
+#include "dlx_bitset_test.h"
+#include "dancing_cells_test.h"
+
+#include <iostream>
+#include <random>
+
+// Unlink the nodes of option o, counted from 0, from their items' lists
+static void unlinkOption(RandomDriver &driver, int o) {
+  int option = -1;
+  for (int i = driver.hnodes_size; i < driver.vnodes_size - 1; i++) {
+    Dlx::VNode &node = driver.vnodes[i];
+    if (node.top == nullptr) {
+      option++;
+    } else if (option == o) {
+      node.up->down = node.down;
+      node.down->up = node.up;
+      node.top->size--;
+    }
+  }
+}
+
+void BitsetDlxTest::compareSolutions() {
+  int invalid = 0;
+  auto validate = [&](std::span<Dlx::VNode *const> solution) {
+    invalid += !DancingCellsTest(driver).validateSolution(solution);
+    return true;
+  };
+
+  Dlx dlx;
+  std::uint64_t dlx_count = dlx.solveAll(driver, validate);
+  BitsetDlx bits;
+  std::uint64_t bits_count = bits.solveAll(driver, validate);
+
+  if (dlx_count != bits_count || invalid != 0) {
+    std::cout << "FAILED solution count dlx: " << dlx_count
+              << " bits: " << bits_count << " invalid: " << invalid << "\n";
+  }
+}
+
+void BitsetDlxTest::compareRandom(int count, std::uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  for (int n = 0; n < count; n++) {
+    int items = 2 + rng() % 14;
+    std::vector<std::vector<int>> options =
+        randomOptions(items, 1 + rng() % 30, rng);
+
+    RandomDriver driver;
+    driver.generate(items, options);
+    for (std::size_t o = 0; o < options.size(); o++) {
+      if (rng() % 8 == 0) {
+        unlinkOption(driver, o);
+      }
+    }
+    BitsetDlxTest(&driver).compareSolutions();
+  }
+  std::cout << "Compared " << count << " random matrices using the "
+            << BitsetDlx::kernel() << " kernel\n";
+}
+
+void BitsetDlxTest::compareLimits() {
+  // Pairs {2k + 1, 2k + 2} are the only options covering the even items,
+  // the rest join two odd items, so the pairs are the one solution
+  auto check = [](int items, int options_count, bool fits) {
+    std::mt19937_64 rng(items * 7919 + options_count);
+    std::vector<std::vector<int>> options;
+    for (int i = 1; i < items; i += 2) {
+      options.push_back({i, i + 1});
+    }
+    if (items % 2 == 1) {
+      options.push_back({items});
+    }
+    while (int(options.size()) < options_count) {
+      int a = 1 + 2 * (rng() % (items / 2));
+      int b = 1 + 2 * (rng() % (items / 2));
+      if (a != b) {
+        options.push_back({std::min(a, b), std::max(a, b)});
+      }
+    }
+
+    RandomDriver driver;
+    driver.generate(items, options);
+    BitsetDlx bits;
+    if (bits.generate(&driver) != fits) {
+      std::cout << "FAILED " << items << " items " << options_count
+                << " options " << (fits ? "fell back" : "did not fall back")
+                << "\n";
+    }
+    BitsetDlxTest(&driver).compareSolutions();
+  };
+
+  check(BitsetDlx::max_items, BitsetDlx::max_options, true);
+  check(BitsetDlx::max_items + 1, BitsetDlx::max_options, false);
+  check(BitsetDlx::max_items, BitsetDlx::max_options + 1, false);
+
+  // Without options the bitsets have no words at all
+  RandomDriver empty;
+  empty.generate(3, {});
+  BitsetDlxTest(&empty).compareSolutions();
+  std::cout << "Compared matrices at the bitset limits\n";
+}
+
+void BitsetDlxTest::compareKernels(int count, std::uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  std::vector<BitsetDlx::Kernel> kernels = BitsetDlx::kernels();
+  for (int n = 0; n < count; n++) {
+    // Few distinct counts so the first of several minimums is checked, with
+    // some items covered and sometimes all of them
+    int size = 1 + rng() % BitsetDlx::max_items;
+    int range = 1 + rng() % 8;
+    int covered = rng() % 4;
+    BitsetDlx::Counts counts;
+    counts.fill(BitsetDlx::inactive);
+    for (int c = 0; c < size; c++) {
+      if (covered == 3 || (covered > 0 && rng() % 2 == 0)) {
+        continue;
+      }
+      counts[c] = rng() % range;
+    }
+
+    int expected = kernels[0].select(counts.data(), size);
+    for (const auto &kernel : kernels) {
+      int c = kernel.select(counts.data(), size);
+      if (c != expected) {
+        std::cout << "FAILED " << kernel.name << " kernel picked " << c
+                  << " scalar picked " << expected << " of " << size << "\n";
+      }
+    }
+  }
+  std::cout << "Compared " << kernels.size() << " kernels on " << count
+            << " random counts\n";
+}
+
+#ifdef DLX_BITSET_TEST_MAIN
+
+int main() {
+  BitsetDlxTest::compareRandom(2000, 1);
+  BitsetDlxTest::compareLimits();
+  BitsetDlxTest::compareKernels(20000, 1);
+  return 0;
+}
+
+#endif
@@ -0,0 +1,25 @@
+#pragma once
+#include "dlx_bitset.h"
+
+#include <cstdint>
+
+// Differential tests of BitsetDlx against Dlx on the same matrices
+class BitsetDlxTest {
+public:
+  Dlx::Driver *driver;
+  BitsetDlxTest(Dlx::Driver *driver_) : driver(driver_) {}
+
+  void compareSolutions();
+
+  // Compare both engines on count random matrices, unlinking some options
+  // the way symmetry removal does
+  static void compareRandom(int count, std::uint64_t seed);
+
+  // Matrices at the item and option limits use the bitsets, one item or
+  // option more falls back to Dlx, both giving the same count
+  static void compareLimits();
+
+  // Every kernel the CPU supports picks the same item as the scalar one on
+  // count random sets of counts
+  static void compareKernels(int count, std::uint64_t seed);
+};
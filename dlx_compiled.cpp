@@ -0,0 +1,98 @@
+#include "dlx_compiled.h"
+#include "dlx_trace.h"
+
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+
+void CompiledProblem::compile(Dlx::Driver *driver) {
+  DLX_TRACE_SPAN("compile");
+  arena.assign(driver);
+  source_vnodes = driver->vnodes;
+
+  image.hnodes = arena.hnodes;
+  image.vnodes = arena.vnodes;
+  image.hnodes_size = driver->hnodes_size;
+  image.vnodes_size = driver->vnodes_size;
+  image.solution_size = driver->solution_size;
+
+  costs.clear();
+  image.costs = nullptr;
+  if (driver->costs != nullptr) {
+    costs.assign(driver->costs, driver->costs + driver->vnodes_size);
+    image.costs = costs.data();
+  }
+
+  image.page_size = arena.stats.page_size;
+  image.pages = arena.stats.pages;
+}
+
+Dlx::VNode *CompiledProblem::translate(const Dlx::Driver *copy,
+                                       Dlx::VNode *node) const {
+  return source_vnodes + (node - copy->vnodes);
+}
+
+// Shift a link by delta bytes, leaving null links alone
+template <typename T> static void shift(T *&node, std::uintptr_t delta) {
+  if (node != nullptr) {
+    node = reinterpret_cast<T *>(reinterpret_cast<std::uintptr_t>(node) +
+                                 delta);
+  }
+}
+
+void ProblemCopy::load(const CompiledProblem &problem) {
+  const Dlx::Driver &image = problem.image;
+  arena.reserve(image.hnodes_size, image.vnodes_size);
+  std::memcpy(arena.data, problem.arena.data, arena.size);
+
+  hnodes = arena.hnodes;
+  vnodes = arena.vnodes;
+  hnodes_size = image.hnodes_size;
+  vnodes_size = image.vnodes_size;
+  solution_size = image.solution_size;
+  costs = image.costs;
+  page_size = arena.stats.page_size;
+  pages = arena.stats.pages;
+
+  // Both arrays live in one block so every link moves by the same amount
+  std::uintptr_t delta = reinterpret_cast<std::uintptr_t>(arena.data) -
+                         reinterpret_cast<std::uintptr_t>(problem.arena.data);
+  for (int i = 0; i < hnodes_size; i++) {
+    shift(hnodes[i].left, delta);
+    shift(hnodes[i].right, delta);
+  }
+  for (int i = 0; i < vnodes_size; i++) {
+    shift(vnodes[i].up, delta);
+    shift(vnodes[i].down, delta);
+    if (i >= hnodes_size) {
+      shift(vnodes[i].top, delta);
+    }
+  }
+}
+
+std::uint64_t ProblemSolver::solveAll(const CompiledProblem &problem,
+                                      const Dlx::Visit &visit) {
+  copy.load(problem);
+  // Capturing two pointers keeps std::function from allocating
+  auto context = std::tie(problem, visit);
+  return dlx.solveAll(&copy, [this, &context](
+                                 std::span<Dlx::VNode *const> found) {
+    solution.clear();
+    for (Dlx::VNode *i : found) {
+      solution.push_back(std::get<0>(context).translate(&copy, i));
+    }
+    return std::get<1>(context)(solution);
+  });
+}
+
+std::span<Dlx::VNode *const>
+ProblemSolver::solve(const CompiledProblem &problem) {
+  solution.clear();
+  solveAll(problem, [](std::span<Dlx::VNode *const>) { return false; });
+  return solution;
+}
+
+ProblemSolver &ProblemSolver::threadLocal() {
+  static thread_local ProblemSolver solver;
+  return solver;
+}
@@ -0,0 +1,67 @@
+/*
+ * Compiled problems
+ *
+ * Dlx dances on the driver's own nodes, so a driver can only ever be
+ * solved by one search at a time. A compiled problem takes a pristine
+ * copy of the driver's matrix once and never solves it. Solvers copy that
+ * image into their own arena, which is a single memcpy followed by one
+ * pass adding the distance between the two arenas to every link.
+ *
+ * Any number of threads can share one compiled problem. A solver keeps
+ * its arena and scratch space between solves, so once it has seen a
+ * problem at least as big, solving allocates nothing. Each thread gets
+ * one through ProblemSolver::threadLocal.
+ */
+
+#pragma once
+#include "dlx.h"
+#include "dlx_arena.h"
+
+#include <span>
+#include <vector>
+
+class CompiledProblem {
+public:
+  NodeArena arena;
+
+  // The pristine matrix in arena. Links that pointed outside the driver's
+  // arrays are null. Read only engines may use it directly.
+  Dlx::Driver image;
+
+  // Nodes of the driver this was compiled from
+  Dlx::VNode *source_vnodes;
+
+  // Copy of the driver's costs if it had any, shared by every copy
+  std::vector<double> costs;
+
+  // The driver must not be mid solve
+  void compile(Dlx::Driver *driver);
+
+  // Map a node of the image or any copy back to the driver's node
+  Dlx::VNode *translate(const Dlx::Driver *copy, Dlx::VNode *node) const;
+};
+
+// A private copy of a compiled problem to solve on
+class ProblemCopy : public Dlx::Driver {
+public:
+  NodeArena arena;
+
+  void load(const CompiledProblem &problem);
+};
+
+struct ProblemSolver {
+  ProblemCopy copy;
+  Dlx dlx;
+
+  // Solution translated to the driver's nodes
+  std::vector<Dlx::VNode *> solution;
+
+  // Visits solutions as nodes of the driver the problem was compiled from
+  std::uint64_t solveAll(const CompiledProblem &problem,
+                         const Dlx::Visit &visit);
+
+  // Valid until the next solve
+  std::span<Dlx::VNode *const> solve(const CompiledProblem &problem);
+
+  static ProblemSolver &threadLocal();
+};
@@ -0,0 +1,149 @@
+#include "dlx_lazy.h"
+
+void LazyDlx::Options::add(std::uint64_t id,
+                           std::span<const int> option_items) {
+  ids.push_back(id);
+  items.insert(items.end(), option_items.begin(), option_items.end());
+  begin.push_back(items.size());
+}
+
+void LazyDlx::Options::clear() {
+  ids.clear();
+  begin.resize(1);
+  items.clear();
+}
+
+const LazyDlx::Options &LazyDlx::optionsOf(int item) {
+  auto iter = cache.find(item);
+  if (iter != cache.end()) {
+    stats.cache_hits++;
+    return iter->second;
+  }
+  stats.cache_misses++;
+
+  // Dropping everything is crude but the levels keep their own copies,
+  // so nothing in use is lost
+  if (cached >= cache_limit) {
+    cache.clear();
+    cached = 0;
+  }
+
+  Options &options = cache[item];
+  driver->generateOptions(item, options);
+  stats.generated += options.size();
+  cached += options.size();
+  return options;
+}
+
+bool LazyDlx::available(const Options &options, int k) const {
+  for (int i = options.begin[k]; i < options.begin[k + 1]; i++) {
+    if (covered[options.items[i]]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int LazyDlx::countOptions(int item) {
+  int count = driver->countOptions(item, covered);
+  if (count != -1) {
+    return count;
+  }
+
+  const Options &options = optionsOf(item);
+  count = 0;
+  for (int k = 0; k < options.size(); k++) {
+    count += available(options, k);
+  }
+  return count;
+}
+
+int LazyDlx::selectItem(int &min_value) {
+  int min_i = -1;
+  for (int i : driver->items) {
+    if (covered[i]) {
+      continue;
+    }
+    int value = countOptions(i);
+    if (min_i == -1 || value < min_value) {
+      min_value = value;
+      min_i = i;
+      if (value == 0) {
+        break;
+      }
+    }
+  }
+  return min_i;
+}
+
+void LazyDlx::setCovered(const Options &options, int k, char value) {
+  for (int i = options.begin[k]; i < options.begin[k + 1]; i++) {
+    covered[options.items[i]] = value;
+  }
+}
+
+std::uint64_t LazyDlx::solveAll(Driver *driver_, const Visit &visit) {
+  driver = driver_;
+  stats = {};
+  cache.clear();
+  cached = 0;
+
+  covered.assign(driver->item_count, true);
+  for (int i : driver->items) {
+    covered[i] = false;
+  }
+  levels.resize(driver->items.size() + 1);
+  std::vector<std::uint64_t> solution(driver->items.size());
+
+  std::uint64_t count = 0;
+  int level = 0;
+  for (;;) {
+    int min_value;
+    int c = selectItem(min_value);
+
+    Level &current = levels[level];
+    current.candidates.clear();
+    current.next = 0;
+    if (c == -1) {
+      count++;
+      if (!visit({solution.data(), std::size_t(level)})) {
+        return count;
+      }
+    } else if (min_value > 0) {
+      const Options &options = optionsOf(c);
+      for (int k = 0; k < options.size(); k++) {
+        if (available(options, k)) {
+          current.candidates.add(
+              options.ids[k], {options.items.data() + options.begin[k],
+                               options.items.data() + options.begin[k + 1]});
+        }
+      }
+    }
+
+    // Backtrack until some level has candidates left
+    while (levels[level].next == levels[level].candidates.size()) {
+      if (level == 0) {
+        return count;
+      }
+      level--;
+      setCovered(levels[level].candidates, levels[level].next - 1, false);
+    }
+
+    Level &choice = levels[level];
+    setCovered(choice.candidates, choice.next, true);
+    solution[level] = choice.candidates.ids[choice.next];
+    choice.next++;
+
+    stats.nodes++;
+    level++;
+  }
+}
+
+std::vector<std::uint64_t> LazyDlx::solve(Driver *driver) {
+  std::vector<std::uint64_t> solution;
+  solveAll(driver, [&](std::span<const std::uint64_t> found) {
+    solution.assign(found.begin(), found.end());
+    return false;
+  });
+  return solution;
+}
@@ -0,0 +1,98 @@
+/*
+ * Exact cover over implicit matrices
+ *
+ * Dlx needs every option linked into the matrix before the search starts,
+ * which is hopeless when there are billions of candidate options and the
+ * search only ever looks at a sliver of them. Here the driver describes
+ * the matrix through callbacks instead. Only when the search selects an
+ * item does it ask the driver for the options containing that item,
+ * keeping them in a bounded cache in case the item is selected again.
+ *
+ * Instead of dancing, the search keeps a flag per item saying whether it
+ * is covered. An option is still available if none of its items are
+ * covered, so choosing one only has to set the flags of its items and
+ * backtracking clears them again. Memory is the cache plus the options of
+ * the items selected along the current path.
+ *
+ * To pick the item with the fewest options the search needs a count for
+ * every uncovered item. Drivers that can count cheaply should override
+ * countOptions, otherwise every item's options are generated to count
+ * them which defeats the point on truly huge matrices.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+struct LazyDlx {
+  // Options appended by a driver. Option k has id ids[k] and its items are
+  // items[begin[k]] up to items[begin[k + 1]].
+  struct Options {
+    std::vector<std::uint64_t> ids;
+    std::vector<int> begin = {0};
+    std::vector<int> items;
+
+    int size() const { return ids.size(); }
+    void add(std::uint64_t id, std::span<const int> option_items);
+    void clear();
+  };
+
+  class Driver {
+  public:
+    // Items to cover, numbered below item_count. Other items count as
+    // covered from the start, options containing them are never chosen.
+    std::vector<int> items;
+    int item_count;
+
+    virtual ~Driver() = default;
+
+    // Append every option containing item, covered items or not
+    virtual void generateOptions(int item, Options &options) = 0;
+
+    // Number of options containing item none of whose items are covered,
+    // or -1 to have the solver generate the options and count them
+    virtual int countOptions(int, const std::vector<char> &) {
+      return -1;
+    }
+  };
+
+  struct Stats {
+    std::uint64_t nodes = 0;
+    std::uint64_t generated = 0;
+    std::uint64_t cache_hits = 0;
+    std::uint64_t cache_misses = 0;
+  };
+
+  // Options held in the cache before it is dropped
+  std::size_t cache_limit = 1 << 20;
+  std::unordered_map<int, Options> cache;
+  std::size_t cached = 0;
+
+  struct Level {
+    Options candidates;
+    int next;
+  };
+
+  Driver *driver;
+  std::vector<char> covered;
+  std::vector<Level> levels;
+  Stats stats;
+
+  const Options &optionsOf(int item);
+  bool available(const Options &options, int k) const;
+  int countOptions(int item);
+  int selectItem(int &min_value);
+
+  void setCovered(const Options &options, int k, char value);
+
+  // Called with the ids of each solution's options, returns whether to
+  // keep searching
+  using Visit = std::function<bool(std::span<const std::uint64_t>)>;
+
+  std::uint64_t solveAll(Driver *driver, const Visit &visit);
+  std::vector<std::uint64_t> solve(Driver *driver);
+};
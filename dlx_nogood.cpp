@@ -0,0 +1,40 @@
+#include "dlx_nogood.h"
+
+#include <algorithm>
+#include <bit>
+
+void NogoodTable::reserve(std::size_t memory) {
+  std::size_t count = std::bit_floor(std::max<std::size_t>(
+      memory / sizeof(Bucket), 1));
+  if (count != bucket_count) {
+    buckets = std::make_unique<Bucket[]>(count);
+    bucket_count = count;
+  }
+}
+
+void NogoodTable::clear() {
+  for (std::size_t i = 0; i < bucket_count; i++) {
+    buckets[i] = {};
+  }
+}
+
+bool NogoodTable::contains(const Signature &signature) const {
+  const Bucket &bucket = buckets[signature.a & (bucket_count - 1)];
+  for (const Signature &i : bucket.entries) {
+    if (i == signature) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void NogoodTable::insert(const Signature &signature) {
+  Bucket &bucket = buckets[signature.a & (bucket_count - 1)];
+  for (Signature &i : bucket.entries) {
+    if (i == Signature{0, 0}) {
+      i = signature;
+      return;
+    }
+  }
+  bucket.entries[signature.b & 3] = signature;
+}
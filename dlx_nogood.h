@@ -0,0 +1,58 @@
+/*
+ * Failed subproblem cache
+ *
+ * In exact cover the subproblem left after some choices is determined by
+ * which items are covered, as the remaining options are exactly those
+ * touching no covered item. Different orders of choices often reach the
+ * same set of covered items, and without memory the search proves the
+ * same subproblem unsolvable again every time.
+ *
+ * The search keeps a Zobrist signature of the covered items, the xor of a
+ * random key per covered item, updated as items are covered and
+ * uncovered. When a subtree is exhausted without a solution its signature
+ * goes into this table, and the search checks the table before exploring
+ * a node. Signatures are 128 bits so a false match, which would wrongly
+ * prune, is vanishingly unlikely.
+ *
+ * The table is a fixed number of 64 byte buckets of four signatures
+ * sized from a memory cap. When a bucket is full a new signature
+ * replaces one of the four. Each solve draws fresh item keys, so entries
+ * left from earlier solves never match and the table needs no clearing.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+struct Signature {
+  std::uint64_t a;
+  std::uint64_t b;
+
+  Signature &operator^=(const Signature &other) {
+    a ^= other.a;
+    b ^= other.b;
+    return *this;
+  }
+  friend bool operator==(const Signature &x, const Signature &y) {
+    return x.a == y.a && x.b == y.b;
+  }
+};
+
+struct NogoodTable {
+  struct Bucket {
+    Signature entries[4];
+  };
+
+  std::unique_ptr<Bucket[]> buckets;
+  std::size_t bucket_count = 0;
+
+  // Size the table to fit in memory bytes, rounded down to a power of two
+  // buckets. Only reallocates, emptying it, when the size changes.
+  void reserve(std::size_t memory);
+  void clear();
+
+  bool contains(const Signature &signature) const;
+  void insert(const Signature &signature);
+};
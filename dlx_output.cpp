@@ -0,0 +1,236 @@
+#include "dlx_output.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <unistd.h>
+
+static constexpr char magic[4] = {'D', 'L', 'X', 'S'};
+
+static char *putFixed(char *out, std::uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    *out++ = char(value >> (8 * i));
+  }
+  return out;
+}
+
+static char *putVarint(char *out, std::uint32_t value) {
+  while (value >= 0x80) {
+    *out++ = char(value | 0x80);
+    value >>= 7;
+  }
+  *out++ = char(value);
+  return out;
+}
+
+void SolutionWriter::open(int fd, SolutionFormat format,
+                          std::uint32_t options, std::size_t capacity) {
+  this->fd = fd;
+  this->format = format;
+  if (capacity > this->capacity) {
+    buffer = std::make_unique_for_overwrite<char[]>(capacity);
+    this->capacity = capacity;
+  }
+  size = 0;
+  count = 0;
+  failed = false;
+
+  if (format != SolutionFormat::Text) {
+    std::memcpy(buffer.get(), magic, sizeof(magic));
+    buffer[sizeof(magic)] = char(format);
+    size = putFixed(buffer.get() + sizeof(magic) + 1, options) - buffer.get();
+  }
+}
+
+void SolutionWriter::write(std::span<const std::uint32_t> ids) {
+  // Most bytes the solution can take
+  std::size_t need = 0;
+  switch (format) {
+  case SolutionFormat::Text:
+    need = 1;
+    for (std::uint32_t id : ids) {
+      need += (lines.empty() ? 10 : lines[id].size()) + 1;
+    }
+    break;
+  case SolutionFormat::Binary:
+    need = 4 * (ids.size() + 1);
+    break;
+  case SolutionFormat::Packed:
+    need = 5 * (ids.size() + 1);
+    break;
+  }
+
+  if (size + need > capacity) {
+    flush();
+    if (need > capacity) {
+      buffer = std::make_unique_for_overwrite<char[]>(need);
+      capacity = need;
+    }
+  }
+
+  char *out = buffer.get() + size;
+  switch (format) {
+  case SolutionFormat::Text:
+    if (count > 0) {
+      *out++ = '\n';
+    }
+    for (std::uint32_t id : ids) {
+      if (lines.empty()) {
+        out = std::to_chars(out, out + 10, id).ptr;
+      } else {
+        std::memcpy(out, lines[id].data(), lines[id].size());
+        out += lines[id].size();
+      }
+      *out++ = '\n';
+    }
+    break;
+  case SolutionFormat::Binary:
+    out = putFixed(out, ids.size());
+    for (std::uint32_t id : ids) {
+      out = putFixed(out, id);
+    }
+    break;
+  case SolutionFormat::Packed:
+    sorted.assign(ids.begin(), ids.end());
+    std::sort(sorted.begin(), sorted.end());
+    out = putVarint(out, sorted.size());
+    std::uint32_t prev = 0;
+    for (std::uint32_t id : sorted) {
+      out = putVarint(out, id - prev);
+      prev = id;
+    }
+    break;
+  }
+
+  size = out - buffer.get();
+  count++;
+}
+
+void SolutionWriter::append(std::string_view bytes) {
+  if (size + bytes.size() > capacity) {
+    flush();
+    if (bytes.size() > capacity) {
+      buffer = std::make_unique_for_overwrite<char[]>(bytes.size());
+      capacity = bytes.size();
+    }
+  }
+  std::memcpy(buffer.get() + size, bytes.data(), bytes.size());
+  size += bytes.size();
+}
+
+bool SolutionWriter::flush() {
+  std::size_t written = 0;
+  while (written < size && !failed) {
+    ssize_t n = ::write(fd, buffer.get() + written, size - written);
+    if (n < 0 && errno != EINTR) {
+      failed = true;
+    } else if (n > 0) {
+      written += n;
+    }
+  }
+  size = 0;
+  return !failed;
+}
+
+bool SolutionReader::open(int fd, std::size_t capacity) {
+  this->fd = fd;
+  if (capacity > this->capacity) {
+    buffer = std::make_unique_for_overwrite<char[]>(capacity);
+    this->capacity = capacity;
+  }
+  begin = 0;
+  end = 0;
+  failed = false;
+
+  for (char c : magic) {
+    if (readByte() != c) {
+      return false;
+    }
+  }
+  int byte = readByte();
+  if (byte != int(SolutionFormat::Binary) &&
+      byte != int(SolutionFormat::Packed)) {
+    return false;
+  }
+  format = SolutionFormat(byte);
+  return readFixed(options);
+}
+
+int SolutionReader::readByte() {
+  if (begin == end) {
+    ssize_t n;
+    do {
+      n = ::read(fd, buffer.get(), capacity);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+      failed = failed || n < 0;
+      return -1;
+    }
+    begin = 0;
+    end = n;
+  }
+  return static_cast<unsigned char>(buffer[begin++]);
+}
+
+bool SolutionReader::readVarint(std::uint32_t &value) {
+  value = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    int byte = readByte();
+    if (byte < 0) {
+      return false;
+    }
+    value |= std::uint32_t(byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool SolutionReader::readFixed(std::uint32_t &value) {
+  value = 0;
+  for (int i = 0; i < 4; i++) {
+    int byte = readByte();
+    if (byte < 0) {
+      return false;
+    }
+    value |= std::uint32_t(byte) << (8 * i);
+  }
+  return true;
+}
+
+bool SolutionReader::next(std::vector<std::uint32_t> &ids) {
+  // Input ending before a solution is the clean end, so peek at its first
+  // byte and put it back
+  if (readByte() < 0) {
+    return false;
+  }
+  begin--;
+
+  // Counts past the option count are corrupt, so never allocated
+  std::uint32_t count;
+  bool packed = format == SolutionFormat::Packed;
+  if (!(packed ? readVarint(count) : readFixed(count)) || count > options) {
+    failed = true;
+    return false;
+  }
+
+  ids.resize(count);
+  std::uint32_t prev = 0;
+  for (std::uint32_t &id : ids) {
+    if (!(packed ? readVarint(id) : readFixed(id))) {
+      failed = true;
+      return false;
+    }
+    if (packed) {
+      id += prev;
+      prev = id;
+    }
+    if (id >= options) {
+      failed = true;
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,94 @@
+/*
+ * Bulk solution output
+ *
+ * Enumerating every solution of a large problem can produce millions of
+ * solutions a second, far more than iostreams keep up with. Solutions are
+ * written as arrays of option ids, numbered from 0 in the order the
+ * driver built them, into one large buffer that goes to the file
+ * descriptor in a single write when full.
+ *
+ * Text writes each option's line, or its id if no lines were given,
+ * followed by a newline with an empty line between solutions.
+ *
+ * Binary starts with the magic DLXS, a format byte and the problem's
+ * option count as a little endian 32 bit number. It then gives each
+ * solution as a 32 bit count followed by that many 32 bit ids in the
+ * order they were chosen.
+ *
+ * Packed has the same header, then gives each solution as a varint count
+ * followed by its ids sorted ascending, the first as a varint and each
+ * after as a varint difference from the one before. Varints hold 7 bits a
+ * byte, low bits first, with the high bit set on all but the last byte.
+ * Solutions of nearby options usually take one byte an id.
+ *
+ * SolutionReader reads either binary format back, see
+ * drivers/decode_driver.cpp. A file cut off between solutions reads as
+ * fewer solutions, one cut off inside a solution, or holding a count or id
+ * past the option count, sets failed.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+enum class SolutionFormat : std::uint8_t { Text = 0, Binary = 1, Packed = 2 };
+
+struct SolutionWriter {
+  int fd = 1;
+  SolutionFormat format = SolutionFormat::Text;
+
+  // Text of each option by id for text output
+  std::vector<std::string_view> lines;
+
+  std::unique_ptr<char[]> buffer;
+  std::size_t capacity = 0;
+  std::size_t size = 0;
+
+  std::uint64_t count = 0;
+  bool failed = false;
+
+  // Scratch space for sorting packed ids
+  std::vector<std::uint32_t> sorted;
+
+  // Start writing to fd, the binary formats begin with their header
+  // giving the option count
+  void open(int fd, SolutionFormat format, std::uint32_t options = 0,
+            std::size_t capacity = 1 << 20);
+  void write(std::span<const std::uint32_t> ids);
+  // Copy bytes already formatted, as batch results are
+  void append(std::string_view bytes);
+
+  // Returns false if any write failed
+  bool flush();
+};
+
+struct SolutionReader {
+  int fd = 0;
+  SolutionFormat format;
+  // Option count from the header, no solution has more ids or a larger id
+  std::uint32_t options = 0;
+  // Set when next stops at a truncated or corrupt solution or a read error
+  // rather than the end of input
+  bool failed = false;
+
+  std::unique_ptr<char[]> buffer;
+  std::size_t capacity = 0;
+  std::size_t begin = 0;
+  std::size_t end = 0;
+
+  // Read the header, returns false if fd does not hold a binary format
+  bool open(int fd, std::size_t capacity = 1 << 20);
+
+  // Returns false at the end of input or, setting failed, on a truncated
+  // or corrupt solution
+  bool next(std::vector<std::uint32_t> &ids);
+
+  int readByte();
+  bool readVarint(std::uint32_t &value);
+  bool readFixed(std::uint32_t &value);
+};
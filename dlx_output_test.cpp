@@ -0,0 +1,191 @@
+#include "dlx_output_test.h"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using Solutions = std::vector<std::vector<std::uint32_t>>;
+
+// Solutions are small enough to fit in a pipe's buffer, so a pipe stands in
+// for the file without a reader on the other end
+static std::string writeSolutions(SolutionFormat format,
+                                  std::uint32_t options,
+                                  const Solutions &solutions,
+                                  std::vector<std::size_t> *ends = nullptr) {
+  int fds[2];
+  if (::pipe(fds) != 0) {
+    return {};
+  }
+  SolutionWriter writer;
+  writer.open(fds[1], format, options);
+  for (const auto &ids : solutions) {
+    writer.write(ids);
+    if (ends != nullptr) {
+      ends->push_back(writer.size);
+    }
+  }
+  writer.flush();
+  ::close(fds[1]);
+
+  std::string bytes;
+  char buffer[4096];
+  ssize_t n;
+  while ((n = ::read(fds[0], buffer, sizeof(buffer))) > 0) {
+    bytes.append(buffer, n);
+  }
+  ::close(fds[0]);
+  return bytes;
+}
+
+// Read back bytes, returning the solutions before the end or a failure
+static Solutions readSolutions(const std::string &bytes, bool &opened,
+                               bool &failed) {
+  int fds[2];
+  Solutions solutions;
+  opened = false;
+  failed = true;
+  if (::pipe(fds) != 0) {
+    return solutions;
+  }
+  bool written =
+      ::write(fds[1], bytes.data(), bytes.size()) == ssize_t(bytes.size());
+  ::close(fds[1]);
+
+  SolutionReader reader;
+  opened = written && reader.open(fds[0]);
+  std::vector<std::uint32_t> ids;
+  while (opened && reader.next(ids)) {
+    solutions.push_back(ids);
+  }
+  failed = reader.failed;
+  ::close(fds[0]);
+  return solutions;
+}
+
+static Solutions randomSolutions(std::uint32_t options, int count,
+                                 std::mt19937_64 &rng) {
+  Solutions solutions(count);
+  for (auto &ids : solutions) {
+    // Empty solutions and ids needing several varint bytes are included
+    ids.resize(rng() % 6);
+    for (std::uint32_t &id : ids) {
+      id = rng() % options;
+    }
+  }
+  return solutions;
+}
+
+void SolutionOutputTest::roundTrip(SolutionFormat format,
+                                   std::uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  const std::uint32_t options = 100000;
+  Solutions solutions = randomSolutions(options, 200, rng);
+  std::string bytes = writeSolutions(format, options, solutions);
+
+  if (format == SolutionFormat::Text) {
+    std::string expected;
+    for (std::size_t s = 0; s < solutions.size(); s++) {
+      expected += s > 0 ? "\n" : "";
+      for (std::uint32_t id : solutions[s]) {
+        expected += std::to_string(id) + "\n";
+      }
+    }
+    if (bytes != expected) {
+      std::cout << "FAILED text output differs\n";
+    }
+    std::cout << "Wrote " << solutions.size() << " text solutions\n";
+    return;
+  }
+
+  // Packed ids come back sorted
+  if (format == SolutionFormat::Packed) {
+    for (auto &ids : solutions) {
+      std::sort(ids.begin(), ids.end());
+    }
+  }
+  bool opened, failed;
+  Solutions read = readSolutions(bytes, opened, failed);
+  if (!opened || failed || read != solutions) {
+    std::cout << "FAILED round trip of format " << int(format)
+              << " opened: " << opened << " failed: " << failed
+              << " solutions: " << read.size() << "\n";
+  }
+  std::cout << "Read back " << solutions.size() << " solutions of format "
+            << int(format) << "\n";
+}
+
+void SolutionOutputTest::readTruncated(SolutionFormat format) {
+  std::mt19937_64 rng(1);
+  const std::uint32_t options = 1000;
+  Solutions solutions = randomSolutions(options, 20, rng);
+  if (format == SolutionFormat::Packed) {
+    for (auto &ids : solutions) {
+      std::sort(ids.begin(), ids.end());
+    }
+  }
+  std::vector<std::size_t> ends;
+  std::string bytes = writeSolutions(format, options, solutions, &ends);
+
+  // A cut inside the header is not a solution file at all
+  std::size_t header_size = writeSolutions(format, options, {}).size();
+  for (std::size_t cut = 0; cut < bytes.size(); cut++) {
+    bool opened, failed;
+    Solutions read = readSolutions(bytes.substr(0, cut), opened, failed);
+    if (cut < header_size) {
+      if (opened) {
+        std::cout << "FAILED opened a header cut at " << cut << "\n";
+      }
+      continue;
+    }
+
+    std::size_t whole =
+        std::upper_bound(ends.begin(), ends.end(), cut) - ends.begin();
+    bool between = cut == header_size ||
+                   std::find(ends.begin(), ends.end(), cut) != ends.end();
+    if (!opened || failed == between || read.size() != whole ||
+        !std::equal(read.begin(), read.end(), solutions.begin())) {
+      std::cout << "FAILED cut at " << cut << " of " << bytes.size()
+                << " read: " << read.size() << " failed: " << failed << "\n";
+    }
+  }
+  std::cout << "Read " << bytes.size() << " truncated files of format "
+            << int(format) << "\n";
+}
+
+void SolutionOutputTest::readCorrupt() {
+  // Binary files of one solution, first with a count past the option
+  // count, then with an id past it
+  bool opened, failed;
+  std::string count = writeSolutions(SolutionFormat::Binary, 2, {{0, 1}});
+  std::size_t header_size =
+      writeSolutions(SolutionFormat::Binary, 2, {}).size();
+  count.replace(header_size, 4, 4, char(0xff));
+  Solutions read = readSolutions(count, opened, failed);
+  if (!opened || !failed || !read.empty()) {
+    std::cout << "FAILED read a count past the option count\n";
+  }
+
+  std::string id = writeSolutions(SolutionFormat::Binary, 2, {{0, 2}});
+  read = readSolutions(id, opened, failed);
+  if (!opened || !failed || !read.empty()) {
+    std::cout << "FAILED read an id past the option count\n";
+  }
+  std::cout << "Rejected corrupt solution files\n";
+}
+
+#ifdef DLX_OUTPUT_TEST_MAIN
+
+int main() {
+  SolutionOutputTest::roundTrip(SolutionFormat::Text, 1);
+  SolutionOutputTest::roundTrip(SolutionFormat::Binary, 2);
+  SolutionOutputTest::roundTrip(SolutionFormat::Packed, 3);
+  SolutionOutputTest::readTruncated(SolutionFormat::Binary);
+  SolutionOutputTest::readTruncated(SolutionFormat::Packed);
+  SolutionOutputTest::readCorrupt();
+  return 0;
+}
+
+#endif
@@ -0,0 +1,19 @@
+#pragma once
+#include "dlx_output.h"
+
+#include <cstdint>
+
+// Checks that solutions written by SolutionWriter read back the same
+class SolutionOutputTest {
+public:
+  // Random solutions over options ids, text compared with the expected
+  // lines and the binary formats read back by SolutionReader
+  static void roundTrip(SolutionFormat format, std::uint64_t seed);
+
+  // Every prefix of a binary file reads back the whole solutions it holds,
+  // and fails unless it ends between solutions
+  static void readTruncated(SolutionFormat format);
+
+  // Counts and ids past the header's option count fail without reading on
+  static void readCorrupt();
+};
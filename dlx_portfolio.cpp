@@ -0,0 +1,53 @@
+#include "dlx_portfolio.h"
+
+#include <thread>
+
+void Portfolio::addSeeded(const Dlx::Config &base, int n) {
+  for (int i = 0; i < n; i++) {
+    Dlx::Config config = base;
+    if (i != 0) {
+      config.randomize = true;
+      config.seed = base.seed + i;
+      if (base.restart == Dlx::Restart::None) {
+        config.restart = i % 2 ? Dlx::Restart::Luby : Dlx::Restart::Geometric;
+      }
+    }
+    configs.push_back(config);
+  }
+}
+
+std::vector<Dlx::VNode *> Portfolio::solve(const CompiledProblem &problem) {
+  std::atomic<bool> done = false;
+  std::vector<Dlx::VNode *> solution;
+  winner = -1;
+
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < configs.size(); i++) {
+    threads.emplace_back([&, i] {
+      ProblemSolver &solver = ProblemSolver::threadLocal();
+      solver.dlx.config = configs[i];
+      solver.copy.arena.config = arena;
+      solver.dlx.cancel = &done;
+      std::span<Dlx::VNode *const> found = solver.solve(problem);
+
+      // A cancelled solver also returns {} but only after done was set
+      if (done.exchange(true)) {
+        return;
+      }
+      solution.assign(found.begin(), found.end());
+      stats = solver.dlx.stats;
+      winner = i;
+    });
+  }
+
+  for (std::thread &i : threads) {
+    i.join();
+  }
+  return solution;
+}
+
+std::vector<Dlx::VNode *> Portfolio::solve(Dlx::Driver *driver) {
+  CompiledProblem problem;
+  problem.compile(driver);
+  return solve(problem);
+}
@@ -0,0 +1,36 @@
+/*
+ * Portfolio solving
+ *
+ * A single deterministic search can wander into a huge barren subtree
+ * and take orders of magnitude longer than a lucky ordering would. A
+ * portfolio runs several differently seeded or configured solvers at once
+ * on separate threads, each on its own copy of the matrix, and returns the
+ * first answer while cancelling the rest. The first solver to finish
+ * decides the result, so a solver exhausting its tree also proves there
+ * is no solution for everyone.
+ */
+
+#pragma once
+#include "dlx.h"
+#include "dlx_compiled.h"
+
+#include <vector>
+
+struct Portfolio {
+  std::vector<Dlx::Config> configs;
+
+  // How each solver's copy of the matrix is allocated. Copies are made on
+  // the solver's thread, so NodeArena::local_node puts each on its node.
+  NodeArena::Config arena;
+
+  // Stats of the solver that decided the result
+  Dlx::Stats stats;
+  int winner = -1;
+
+  // Add n configs derived from base. The first is base itself, the rest are
+  // randomized with distinct seeds and alternate between restart schedules.
+  void addSeeded(const Dlx::Config &base, int n);
+
+  std::vector<Dlx::VNode *> solve(const CompiledProblem &problem);
+  std::vector<Dlx::VNode *> solve(Dlx::Driver *driver);
+};
@@ -0,0 +1,280 @@
+#include "dlx_symmetry.h"
+
+#include <algorithm>
+#include <cctype>
+#include <set>
+#include <unordered_map>
+
+void SymmetryGroup::addOption(std::vector<int> items, double cost) {
+  std::sort(items.begin(), items.end());
+  option_index.emplace(items, options.size());
+  options.push_back(std::move(items));
+  costs.push_back(cost);
+}
+
+// Images of each option, or empty if some option maps to no option or to
+// one of another cost
+std::vector<int>
+SymmetryGroup::optionMap(const std::vector<int> &item_map) const {
+  std::vector<int> option_map;
+  option_map.reserve(options.size());
+  std::vector<int> image;
+  for (std::size_t o = 0; o < options.size(); o++) {
+    image.clear();
+    for (int i : options[o]) {
+      image.push_back(item_map[i]);
+    }
+    std::sort(image.begin(), image.end());
+    auto found = option_index.find(image);
+    if (found == option_index.end() || costs[found->second] != costs[o]) {
+      return {};
+    }
+    option_map.push_back(found->second);
+  }
+  return option_map;
+}
+
+std::string SymmetryGroup::addGenerator(const std::vector<int> &item_map) {
+  if (item_map.size() != std::size_t(item_count) + 1 || item_map[0] != 0) {
+    return "Symmetry does not cover every item\n";
+  }
+  std::vector<bool> seen(item_count + 1);
+  for (int i : item_map) {
+    if (i < 0 || i > item_count || seen[i]) {
+      return "Symmetry is not a permutation of the items\n";
+    }
+    seen[i] = true;
+  }
+  if (!options.empty() && optionMap(item_map).empty()) {
+    return "Symmetry does not map every option to an option of the same"
+           " cost\n";
+  }
+  generators.push_back(item_map);
+  return {};
+}
+
+void SymmetryGroup::detectGrid(const std::vector<std::string> &names) {
+  // Split each name into prefix x separator y
+  struct Cell {
+    std::string prefix;
+    std::string separator;
+    int x;
+    int y;
+  };
+  std::vector<Cell> cells(names.size());
+  std::vector<bool> is_cell(names.size());
+  std::map<std::string, std::pair<int, int>> low, high;
+  std::unordered_map<std::string, int> index;
+
+  for (std::size_t i = 1; i < names.size(); i++) {
+    const std::string &name = names[i];
+    index[name] = i;
+
+    std::size_t y_begin = name.size();
+    while (y_begin > 0 && std::isdigit(name[y_begin - 1])) {
+      y_begin--;
+    }
+    std::size_t x_end = y_begin;
+    while (x_end > 0 && !std::isdigit(name[x_end - 1])) {
+      x_end--;
+    }
+    std::size_t x_begin = x_end;
+    while (x_begin > 0 && std::isdigit(name[x_begin - 1])) {
+      x_begin--;
+    }
+    if (y_begin == name.size() || x_end == y_begin || x_begin == x_end ||
+        name.size() - y_begin > 9 || x_end - x_begin > 9) {
+      continue;
+    }
+
+    Cell &cell = cells[i];
+    cell.prefix = name.substr(0, x_begin);
+    cell.separator = name.substr(x_end, y_begin - x_end);
+    cell.x = std::stoi(name.substr(x_begin, x_end - x_begin));
+    cell.y = std::stoi(name.substr(y_begin));
+    is_cell[i] = true;
+
+    std::string family = cell.prefix + " " + cell.separator;
+    auto [l, inserted] = low.emplace(family, std::pair{cell.x, cell.y});
+    auto [h, _] = high.emplace(family, std::pair{cell.x, cell.y});
+    l->second = {std::min(l->second.first, cell.x),
+                 std::min(l->second.second, cell.y)};
+    h->second = {std::max(h->second.first, cell.x),
+                 std::max(h->second.second, cell.y)};
+  }
+
+  // The 7 non-identity symmetries of a square, the last 4 swap the axes so
+  // only apply to square boxes
+  for (int t = 1; t < 8; t++) {
+    std::vector<int> item_map(names.size());
+    bool valid = true;
+    for (std::size_t i = 1; i < names.size() && valid; i++) {
+      if (!is_cell[i]) {
+        item_map[i] = i;
+        continue;
+      }
+      const Cell &cell = cells[i];
+      std::string family = cell.prefix + " " + cell.separator;
+      auto [x0, y0] = low[family];
+      auto [x1, y1] = high[family];
+      int a = cell.x - x0, b = cell.y - y0;
+      int height = x1 - x0, width = y1 - y0;
+      if (t >= 4 && height != width) {
+        valid = false;
+        break;
+      }
+
+      int x = t & 1 ? height - a : a;
+      int y = t & 2 ? width - b : b;
+      if (t >= 4) {
+        std::swap(x, y);
+      }
+
+      auto found = index.find(cell.prefix + std::to_string(x + x0) +
+                              cell.separator + std::to_string(y + y0));
+      if (found == index.end()) {
+        valid = false;
+      } else {
+        item_map[i] = found->second;
+      }
+    }
+    if (valid && !optionMap(item_map).empty()) {
+      generators.push_back(item_map);
+    }
+  }
+}
+
+std::string SymmetryGroup::close(std::size_t limit) {
+  std::vector<int> identity(item_count + 1);
+  for (int i = 0; i <= item_count; i++) {
+    identity[i] = i;
+  }
+
+  item_maps = {identity};
+  std::set<std::vector<int>> seen = {identity};
+  for (std::size_t e = 0; e < item_maps.size(); e++) {
+    for (const std::vector<int> &g : generators) {
+      std::vector<int> product(item_count + 1);
+      for (int i = 0; i <= item_count; i++) {
+        product[i] = g[item_maps[e][i]];
+      }
+      if (seen.insert(product).second) {
+        if (item_maps.size() == limit) {
+          return "Symmetry group has more than " + std::to_string(limit) +
+                 " elements\n";
+        }
+        item_maps.push_back(std::move(product));
+      }
+    }
+  }
+
+  option_maps.clear();
+  for (const std::vector<int> &item_map : item_maps) {
+    option_maps.push_back(optionMap(item_map));
+  }
+
+  chooseRoot();
+  return {};
+}
+
+void SymmetryGroup::chooseRoot() {
+  root = 0;
+  weights.assign(options.size(), 0);
+  if (item_maps.size() < 2) {
+    return;
+  }
+
+  std::vector<std::vector<int>> item_options(item_count + 1);
+  for (std::size_t o = 0; o < options.size(); o++) {
+    for (int i : options[o]) {
+      item_options[i].push_back(o);
+    }
+  }
+
+  // Keep the item whose options shrink by the largest factor
+  std::size_t best_options = 1, best_kept = 1;
+  std::vector<std::uint64_t> orbit(options.size());
+  for (int i = 1; i <= item_count; i++) {
+    std::vector<int> stabilizer;
+    for (std::size_t g = 0; g < item_maps.size(); g++) {
+      if (item_maps[g][i] == i) {
+        stabilizer.push_back(g);
+      }
+    }
+
+    std::size_t kept = 0;
+    for (int o : item_options[i]) {
+      std::vector<int> images;
+      for (int g : stabilizer) {
+        images.push_back(option_maps[g][o]);
+      }
+      std::sort(images.begin(), images.end());
+      images.erase(std::unique(images.begin(), images.end()), images.end());
+      // The first option of each orbit stands for the rest
+      orbit[o] = images.front() == o ? images.size() : 0;
+      kept += orbit[o] != 0;
+    }
+
+    std::size_t count = item_options[i].size();
+    if (count == 0) {
+      continue;
+    }
+    if (root == 0 || count * best_kept > best_options * kept ||
+        (count * best_kept == best_options * kept && kept < best_kept)) {
+      root = i;
+      best_options = count;
+      best_kept = kept;
+      weights.assign(options.size(), 0);
+      for (int o : item_options[i]) {
+        weights[o] = orbit[o];
+      }
+    }
+  }
+}
+
+bool SymmetryGroup::removed(int option) const {
+  return root != 0 &&
+         std::binary_search(options[option].begin(), options[option].end(),
+                            root) &&
+         weights[option] == 0;
+}
+
+std::uint64_t
+SymmetryGroup::weight(std::span<const std::uint32_t> solution) const {
+  if (root == 0) {
+    return 1;
+  }
+  for (std::uint32_t o : solution) {
+    if (weights[o] != 0) {
+      return weights[o];
+    }
+  }
+  return 0;
+}
+
+bool SymmetryGroup::canonical(std::span<const std::uint32_t> solution) const {
+  if (option_maps.size() < 2) {
+    return true;
+  }
+
+  std::vector<std::uint32_t> sorted(solution.begin(), solution.end());
+  std::sort(sorted.begin(), sorted.end());
+
+  std::vector<std::uint32_t> image(sorted.size());
+  for (std::size_t g = 1; g < option_maps.size(); g++) {
+    bool found = root == 0;
+    for (std::size_t k = 0; k < sorted.size(); k++) {
+      image[k] = option_maps[g][sorted[k]];
+      found = found || weights[image[k]] != 0;
+    }
+    // Only images the reduced search also finds compete
+    if (!found) {
+      continue;
+    }
+    std::sort(image.begin(), image.end());
+    if (image < sorted) {
+      return false;
+    }
+  }
+  return true;
+}
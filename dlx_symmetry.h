@@ -0,0 +1,82 @@
+/*
+ * Symmetry breaking
+ *
+ * Tiling and placement problems are usually symmetric. Rotating or
+ * reflecting a board maps every solution to another one, so a plain
+ * search finds each solution up to eight times over. A symmetry here is a
+ * permutation of the items that maps every option onto another option of
+ * the same cost, so the cheapest solution is kept when minimizing.
+ * The group is generated from declared or detected symmetries.
+ *
+ * Every solution contains exactly one option of any given item, the root.
+ * The symmetries fixing the root, its stabilizer, permute the root's
+ * options among themselves. Any solution can be mapped by one of them to
+ * a solution using the first option of its orbit, so the root only keeps
+ * one option per orbit. The root is the item whose options shrink the
+ * most, ideally one fixed by every symmetry such as a piece's name item,
+ * which divides the search by the size of the group.
+ *
+ * The reduced search still finds every solution using a kept option. A
+ * kept option with an orbit of k stands for k times as many solutions, so
+ * summing weights gives the raw count. A solution is canonical if none of
+ * its images that the reduced search also finds is smaller as a sorted
+ * list of option ids. Counting canonical solutions counts solutions
+ * modulo symmetry, one per orbit.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <span>
+#include <string>
+#include <vector>
+
+struct SymmetryGroup {
+  // Items are numbered as the driver's hnodes, from 1, options from 0.
+  // Each option's items are sorted.
+  int item_count = 0;
+  std::vector<std::vector<int>> options;
+  std::map<std::vector<int>, int> option_index;
+  std::vector<double> costs;
+
+  // Images of each item under each generator
+  std::vector<std::vector<int>> generators;
+
+  // Every element of the group, including the identity first, as images
+  // of each item and of each option
+  std::vector<std::vector<int>> item_maps;
+  std::vector<std::vector<int>> option_maps;
+
+  // Item whose options are restricted, 0 if none, and the orbit size of
+  // each kept option of the root, 0 for every other option
+  int root = 0;
+  std::vector<std::uint64_t> weights;
+
+  // Pass the cost only if it matters, symmetries must keep it
+  void addOption(std::vector<int> items, double cost = 0);
+
+  // Errors if item_map is not a permutation mapping options to options of
+  // the same cost
+  std::string addGenerator(const std::vector<int> &item_map);
+
+  // Add the rotations and reflections of grid items that are symmetries.
+  // Names end in two numbers, as in r3c4 or cell3_4, and are moved within
+  // the bounding box of names sharing their prefix. Other items stay put.
+  void detectGrid(const std::vector<std::string> &names);
+
+  // Generate the group and choose the root, errors if the group has more
+  // than limit elements
+  std::string close(std::size_t limit = 1 << 16);
+
+  // Whether option is removed from the reduced problem
+  bool removed(int option) const;
+
+  // Raw solutions a solution of the reduced problem stands for
+  std::uint64_t weight(std::span<const std::uint32_t> solution) const;
+  bool canonical(std::span<const std::uint32_t> solution) const;
+
+  std::vector<int> optionMap(const std::vector<int> &item_map) const;
+  void chooseRoot();
+};
@@ -0,0 +1,143 @@
+#include "dlx_symmetry_test.h"
+#include "dancing_cells_test.h"
+
+#include <iostream>
+#include <random>
+#include <string>
+
+// Dominoes on an n x n board, items named c<row>_<column> from 1
+struct DominoBoard {
+  int n;
+  std::vector<std::string> names;
+  std::vector<std::vector<int>> options;
+  std::vector<double> costs;
+
+  DominoBoard(int n_, std::mt19937_64 *rng) : n(n_) {
+    names.emplace_back();
+    for (int r = 0; r < n; r++) {
+      for (int c = 0; c < n; c++) {
+        names.push_back("c" + std::to_string(r) + "_" + std::to_string(c));
+      }
+    }
+    for (int r = 0; r < n; r++) {
+      for (int c = 0; c < n; c++) {
+        if (c + 1 < n) {
+          options.push_back({item(r, c), item(r, c + 1)});
+          costs.push_back(cost(r, c, r, c + 1, rng));
+        }
+        if (r + 1 < n) {
+          options.push_back({item(r, c), item(r + 1, c)});
+          costs.push_back(cost(r, c, r + 1, c, rng));
+        }
+      }
+    }
+  }
+
+  int item(int r, int c) const { return 1 + r * n + c; }
+
+  // Random costs, or without rng the distance of the domino's middle from
+  // the board's, which every symmetry of the board keeps
+  double cost(int r0, int c0, int r1, int c1, std::mt19937_64 *rng) const {
+    if (rng != nullptr) {
+      return (*rng)() % 10;
+    }
+    double r = r0 + r1 + 1 - n, c = c0 + c1 + 1 - n;
+    return r * r + c * c;
+  }
+
+  SymmetryGroup group() const {
+    SymmetryGroup symmetry;
+    symmetry.item_count = n * n;
+    for (std::size_t o = 0; o < options.size(); o++) {
+      symmetry.addOption(options[o], costs[o]);
+    }
+    return symmetry;
+  }
+
+  // Cheapest tiling, without the options symmetry removes if given one
+  double minimize(const SymmetryGroup *symmetry) const {
+    RandomDriver driver;
+    driver.generate(n * n, options);
+    std::vector<double> node_costs(driver.vnodes_size);
+    int o = -1;
+    for (int i = driver.hnodes_size; i < driver.vnodes_size - 1; i++) {
+      Dlx::VNode &node = driver.vnodes[i];
+      if (node.top == nullptr) {
+        o++;
+        continue;
+      }
+      node_costs[i] = costs[o];
+      if (symmetry != nullptr && symmetry->removed(o)) {
+        node.up->down = node.down;
+        node.down->up = node.up;
+        node.top->size--;
+      }
+    }
+    driver.costs = node_costs.data();
+
+    Dlx dlx;
+    if (dlx.solveMinCost(&driver).empty()) {
+      return -1;
+    }
+    return dlx.best;
+  }
+};
+
+void SymmetryGroupTest::compareSymmetricCosts() {
+  DominoBoard board(4, nullptr);
+  SymmetryGroup symmetry = board.group();
+  symmetry.detectGrid(board.names);
+  symmetry.close();
+  if (symmetry.item_maps.size() != 8 || symmetry.root == 0) {
+    std::cout << "FAILED detected " << symmetry.item_maps.size()
+              << " symmetries of symmetric costs\n";
+  }
+
+  double full = board.minimize(nullptr);
+  double reduced = board.minimize(&symmetry);
+  if (full != reduced) {
+    std::cout << "FAILED cheapest with symmetry: " << reduced
+              << " expected: " << full << "\n";
+  }
+}
+
+void SymmetryGroupTest::rejectAsymmetricCosts() {
+  std::mt19937_64 rng(1);
+  for (int n = 0; n < 100; n++) {
+    DominoBoard board(4, &rng);
+    SymmetryGroup symmetry = board.group();
+
+    // Reflecting the rows maps every domino to a domino, but not to one of
+    // the same cost
+    std::vector<int> reflect(board.n * board.n + 1);
+    for (int r = 0; r < board.n; r++) {
+      for (int c = 0; c < board.n; c++) {
+        reflect[board.item(r, c)] = board.item(board.n - 1 - r, c);
+      }
+    }
+    if (symmetry.addGenerator(reflect).empty()) {
+      std::cout << "FAILED declared symmetry ignoring costs accepted\n";
+    }
+
+    symmetry.detectGrid(board.names);
+    symmetry.close();
+    double full = board.minimize(nullptr);
+    double reduced = board.minimize(&symmetry);
+    if (full != reduced) {
+      std::cout << "FAILED cheapest with " << symmetry.item_maps.size()
+                << " symmetries: " << reduced << " expected: " << full
+                << "\n";
+    }
+  }
+}
+
+#ifdef DLX_SYMMETRY_TEST_MAIN
+
+int main() {
+  SymmetryGroupTest::compareSymmetricCosts();
+  SymmetryGroupTest::rejectAsymmetricCosts();
+  std::cout << "Compared cheapest tilings with and without symmetry\n";
+  return 0;
+}
+
+#endif
@@ -0,0 +1,15 @@
+#pragma once
+#include "dlx_symmetry.h"
+
+// Checks that symmetry breaking keeps the cheapest solution when
+// minimizing, on dominoes tiling a 4x4 board with costs
+class SymmetryGroupTest {
+public:
+  // Symmetric costs keep every symmetry, the reduced search finds the
+  // same cheapest cost as the full one
+  static void compareSymmetricCosts();
+
+  // Costs no symmetry keeps leave nothing to detect or declare, so the
+  // cheapest cost cannot change
+  static void rejectAsymmetricCosts();
+};
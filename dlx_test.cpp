@@ -0,0 +1,139 @@
+#include "dlx_test.h"
+#include "dancing_cells_test.h"
+
+#include <iostream>
+#include <random>
+
+void DlxTest::compareWeighted(int count, std::uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  auto all = [](std::span<Dlx::VNode *const>) { return true; };
+
+  // One solver keeps its weights across matrices, as a batch worker does
+  Dlx weighted;
+  weighted.config.weighted = true;
+  for (int n = 0; n < count; n++) {
+    int items = 2 + rng() % 14;
+    RandomDriver driver;
+    driver.generate(items, randomOptions(items, 1 + rng() % 30, rng));
+
+    Dlx dlx;
+    std::uint64_t dlx_count = dlx.solveAll(&driver, all);
+    weighted.config.forward_check = n % 2 == 1;
+    std::uint64_t weighted_count = weighted.solveAll(&driver, all);
+    if (dlx_count != weighted_count) {
+      std::cout << "FAILED solution count dlx: " << dlx_count
+                << " weighted: " << weighted_count << "\n";
+    }
+  }
+  std::cout << "Compared " << count << " random matrices weighted\n";
+}
+
+void DlxTest::estimateWeighted() {
+  std::mt19937_64 rng(1);
+  RandomDriver driver;
+  driver.generate(12, randomOptions(12, 40, rng));
+
+  Dlx dlx;
+  Dlx::Estimate plain = dlx.estimate(&driver, 100);
+  Dlx weighted;
+  weighted.config.weighted = true;
+  Dlx::Estimate estimate = weighted.estimate(&driver, 100);
+
+  if (plain.nodes != estimate.nodes || plain.solutions != estimate.solutions) {
+    std::cout << "FAILED weighted estimate nodes: " << estimate.nodes
+              << " solutions: " << estimate.solutions
+              << " expected nodes: " << plain.nodes
+              << " solutions: " << plain.solutions << "\n";
+  }
+  std::cout << "Estimated with weighted selection\n";
+}
+
+void DlxTest::compareMinCost(int count, std::uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  for (int n = 0; n < count; n++) {
+    int items = 2 + rng() % 14;
+    RandomDriver driver;
+    driver.generate(items, randomOptions(items, 1 + rng() % 30, rng));
+    // Every node of an option holds its cost, zero costs included so ties
+    // and free options are covered
+    std::vector<double> costs(driver.vnodes_size);
+    double cost = 0;
+    for (int i = driver.vnodes_size - 1; i >= driver.hnodes_size; i--) {
+      if (driver.vnodes[i].top == nullptr) {
+        cost = rng() % 4 == 0 ? 0 : (rng() % 40) / 4.0;
+      } else {
+        costs[i] = cost;
+      }
+    }
+    driver.costs = costs.data();
+
+    auto coverCost = [&](std::span<Dlx::VNode *const> solution) {
+      double sum = 0;
+      for (Dlx::VNode *node : solution) {
+        sum += costs[node - driver.vnodes];
+      }
+      return sum;
+    };
+    double cheapest = -1;
+    Dlx dlx;
+    dlx.solveAll(&driver, [&](std::span<Dlx::VNode *const> solution) {
+      double sum = coverCost(solution);
+      if (cheapest < 0 || sum < cheapest) {
+        cheapest = sum;
+      }
+      return true;
+    });
+
+    Dlx minimize;
+    std::vector<Dlx::VNode *> solution = minimize.solveMinCost(&driver);
+    double found = solution.empty() ? -1 : coverCost(solution);
+    if (found != cheapest || (!solution.empty() && minimize.best != found)) {
+      std::cout << "FAILED min cost: " << found << " best: " << minimize.best
+                << " expected: " << cheapest << "\n";
+    }
+  }
+  std::cout << "Compared min cost of " << count << " random matrices\n";
+}
+
+void DlxTest::restoreOrder(int count, std::uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  auto all = [](std::span<Dlx::VNode *const>) { return true; };
+
+  for (int n = 0; n < count; n++) {
+    int items = 2 + rng() % 14;
+    RandomDriver driver;
+    driver.generate(items, randomOptions(items, 1 + rng() % 30, rng));
+    std::vector<double> costs(driver.vnodes_size);
+    for (double &cost : costs) {
+      cost = rng() % 10;
+    }
+    driver.costs = costs.data();
+
+    std::vector<Dlx::VNode> built = driver.vnodes_owner;
+    Dlx dlx;
+    dlx.config.seed = n;
+    dlx.config.randomize = n % 2 == 0;
+    dlx.config.minimize = n % 3 != 0;
+    dlx.solveAll(&driver, all);
+    for (int i = 0; i < driver.vnodes_size; i++) {
+      if (driver.vnodes[i].up != built[i].up ||
+          driver.vnodes[i].down != built[i].down) {
+        std::cout << "FAILED option order of node " << i << " changed\n";
+        break;
+      }
+    }
+  }
+  std::cout << "Restored option order of " << count << " random matrices\n";
+}
+
+#ifdef DLX_TEST_MAIN
+
+int main() {
+  DlxTest::compareWeighted(2000, 1);
+  DlxTest::estimateWeighted();
+  DlxTest::compareMinCost(2000, 3);
+  DlxTest::restoreOrder(500, 2);
+  return 0;
+}
+
+#endif
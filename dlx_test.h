@@ -0,0 +1,24 @@
+#pragma once
+#include "dlx.h"
+
+#include <cstdint>
+
+// Tests of Dlx search options against the plain search
+class DlxTest {
+public:
+  // Weighted selection finds as many solutions as minimum size selection
+  // on count random matrices
+  static void compareWeighted(int count, std::uint64_t seed);
+
+  // Estimating with weighted selection walks the same tree as without,
+  // since no weight has been learned yet
+  static void estimateWeighted();
+
+  // The cheapest cover found by branch and bound costs the same as the
+  // cheapest of every cover on count random matrices with random costs
+  static void compareMinCost(int count, std::uint64_t seed);
+
+  // Exhausting a randomized or minimizing search leaves every option
+  // linked where the driver put it
+  static void restoreOrder(int count, std::uint64_t seed);
+};
@@ -0,0 +1,128 @@
+#include "dlx_trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+#ifdef DLX_TRACE_ITT
+#include <ittnotify.h>
+#endif
+#ifdef DLX_TRACE_SDT
+#include <sys/sdt.h>
+#endif
+
+// Buffers outlive their threads so they can be exported after joining, and
+// are handed to later threads so short lived workers do not each add one
+static std::mutex registry_mutex;
+static std::vector<std::unique_ptr<TraceBuffer>> registry;
+static std::vector<TraceBuffer *> released;
+
+struct BufferOwner {
+  TraceBuffer *buffer;
+
+  BufferOwner() {
+    std::lock_guard lock(registry_mutex);
+    if (!released.empty()) {
+      buffer = released.back();
+      released.pop_back();
+      return;
+    }
+    registry.push_back(std::make_unique<TraceBuffer>());
+    buffer = registry.back().get();
+    buffer->thread = registry.size();
+  }
+
+  ~BufferOwner() {
+    std::lock_guard lock(registry_mutex);
+    released.push_back(buffer);
+  }
+};
+
+std::uint64_t Trace::now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+TraceBuffer &Trace::buffer() {
+  static thread_local BufferOwner owner;
+  return *owner.buffer;
+}
+
+void Trace::record(const char *name, std::uint64_t begin, std::uint64_t end,
+                   std::uint64_t arg) {
+  TraceBuffer &trace = buffer();
+  std::uint64_t count = trace.count.load(std::memory_order_relaxed);
+  trace.events[count & (TraceBuffer::capacity - 1)] = {name, begin, end, arg};
+  trace.count.store(count + 1, std::memory_order_release);
+}
+
+std::string Trace::exportChrome() {
+  std::lock_guard lock(registry_mutex);
+
+  // Times are relative to the earliest span kept
+  std::uint64_t origin = UINT64_MAX;
+  for (const auto &trace : registry) {
+    std::uint64_t count = trace->count.load(std::memory_order_acquire);
+    std::uint64_t kept = std::min<std::uint64_t>(count, TraceBuffer::capacity);
+    for (std::uint64_t i = count - kept; i < count; i++) {
+      origin = std::min(origin,
+                        trace->events[i & (TraceBuffer::capacity - 1)].begin);
+    }
+  }
+
+  std::string json = "{\"traceEvents\":[";
+  bool first = true;
+  char line[256];
+  for (const auto &trace : registry) {
+    std::uint64_t count = trace->count.load(std::memory_order_acquire);
+    std::uint64_t kept = std::min<std::uint64_t>(count, TraceBuffer::capacity);
+    for (std::uint64_t i = count - kept; i < count; i++) {
+      const TraceEvent &event = trace->events[i & (TraceBuffer::capacity - 1)];
+      std::snprintf(line, sizeof(line),
+                    "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,"
+                    "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"value\":%llu}}",
+                    first ? "" : ",", event.name, trace->thread,
+                    (event.begin - origin) / 1e3,
+                    (event.end - event.begin) / 1e3,
+                    static_cast<unsigned long long>(event.arg));
+      json += line;
+      first = false;
+    }
+  }
+  json += "\n],\"displayTimeUnit\":\"ns\"}\n";
+  return json;
+}
+
+bool Trace::writeChrome(const std::string &filename) {
+  std::ofstream out(filename);
+  out << exportChrome();
+  return bool(out);
+}
+
+#ifdef DLX_TRACE_ITT
+static __itt_domain *itt_domain = __itt_domain_create("dlx");
+#endif
+
+TraceSpan::TraceSpan(const char *name) : name(name), begin(Trace::now()) {
+#ifdef DLX_TRACE_ITT
+  __itt_task_begin(itt_domain, __itt_null, __itt_null,
+                   __itt_string_handle_create(name));
+#endif
+#ifdef DLX_TRACE_SDT
+  DTRACE_PROBE1(dlx, span_begin, name);
+#endif
+}
+
+TraceSpan::~TraceSpan() {
+#ifdef DLX_TRACE_ITT
+  __itt_task_end(itt_domain);
+#endif
+#ifdef DLX_TRACE_SDT
+  DTRACE_PROBE1(dlx, span_end, name);
+#endif
+  Trace::record(name, begin, Trace::now());
+}
@@ -0,0 +1,84 @@
+/*
+ * Tracing
+ *
+ * Counters say how much work a search did but not when. Built with
+ * DLX_TRACE defined, setup steps, solves, restart runs and backtrack
+ * bursts record timestamped spans into a ring buffer owned by the
+ * recording thread. Recording takes no locks, and once a ring is full the
+ * oldest spans are overwritten. The rings can be exported as Chrome trace
+ * event JSON, viewable in chrome://tracing or Perfetto.
+ *
+ * Also defining DLX_TRACE_ITT marks every scoped span as an ITT task for
+ * VTune, and DLX_TRACE_SDT marks them with static probes, dlx:span_begin
+ * and dlx:span_end, that perf can record.
+ *
+ * Without DLX_TRACE the macros expand to nothing so tracing costs
+ * nothing. Names must be string literals, as only the pointer is kept.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+struct TraceEvent {
+  const char *name;
+  std::uint64_t begin;
+  std::uint64_t end;
+  std::uint64_t arg;
+};
+
+struct TraceBuffer {
+  static constexpr std::size_t capacity = 1 << 16;
+
+  int thread;
+  // Total events recorded, only the last capacity are kept
+  std::atomic<std::uint64_t> count = 0;
+  std::unique_ptr<TraceEvent[]> events =
+      std::make_unique<TraceEvent[]>(capacity);
+};
+
+struct Trace {
+  // Backtracks popping fewer levels than this are not recorded
+  static constexpr int burst_min = 2;
+
+  // Nanoseconds on the steady clock
+  static std::uint64_t now();
+
+  // The calling thread's buffer, registered on first use
+  static TraceBuffer &buffer();
+
+  static void record(const char *name, std::uint64_t begin,
+                     std::uint64_t end, std::uint64_t arg = 0);
+
+  // Only call once recording threads are done
+  static std::string exportChrome();
+  static bool writeChrome(const std::string &filename);
+};
+
+// Records from construction to destruction
+struct TraceSpan {
+  const char *name;
+  std::uint64_t begin;
+
+  TraceSpan(const char *name);
+  ~TraceSpan();
+};
+
+#ifdef DLX_TRACE
+#define DLX_TRACE_CONCAT_(a, b) a##b
+#define DLX_TRACE_CONCAT(a, b) DLX_TRACE_CONCAT_(a, b)
+#define DLX_TRACE_SPAN(name)                                                   \
+  TraceSpan DLX_TRACE_CONCAT(trace_span_, __LINE__)(name)
+#define DLX_TRACE_START(var) std::uint64_t var = Trace::now()
+#define DLX_TRACE_RESTART(var) var = Trace::now()
+#define DLX_TRACE_STOP(var, name, arg)                                         \
+  Trace::record(name, var, Trace::now(), arg)
+#else
+#define DLX_TRACE_SPAN(name)
+#define DLX_TRACE_START(var)
+#define DLX_TRACE_RESTART(var)
+#define DLX_TRACE_STOP(var, name, arg)
+#endif
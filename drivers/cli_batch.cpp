@@ -0,0 +1,295 @@
+#include "cli_batch.h"
+#include "../dlx_trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <thread>
+
+// Call f with each whitespace separated token of line
+template <typename F> static void forEachToken(std::string_view line, F f) {
+  std::size_t i = 0;
+  while (i < line.size()) {
+    while (i < line.size() && std::isspace(line[i])) {
+      i++;
+    }
+    std::size_t j = i;
+    while (j < line.size() && !std::isspace(line[j])) {
+      j++;
+    }
+    if (j > i) {
+      f(line.substr(i, j - i));
+    }
+    i = j;
+  }
+}
+
+std::string BatchWorker::parse(std::string_view text) {
+  DLX_TRACE_SPAN("parse");
+  lines.clear();
+  std::size_t begin = 0;
+  while (begin < text.size()) {
+    std::size_t end = text.find('\n', begin);
+    if (end == std::string_view::npos) {
+      end = text.size();
+    }
+    lines.push_back(text.substr(begin, end - begin));
+    begin = end + 1;
+  }
+  if (lines.empty()) {
+    return "Empty instance\n";
+  }
+
+  items.clear();
+  forEachToken(lines[0], [&](std::string_view name) {
+    items.emplace_back(name, items.size() + 1);
+  });
+  std::stable_sort(items.begin(), items.end(), [](auto &a, auto &b) {
+    return a.first < b.first;
+  });
+
+  // Count first so the arena is sized once
+  option_lines.clear();
+  int nodes = 0;
+  for (std::size_t k = 1; k < lines.size() && !lines[k].empty(); k++) {
+    option_lines.push_back(lines[k]);
+    forEachToken(lines[k], [&](std::string_view token) {
+      nodes += token[0] != '$';
+    });
+  }
+
+  driver.hnodes_size = items.size() + 1;
+  driver.vnodes_size = driver.hnodes_size + nodes + option_lines.size() + 1;
+  driver.solution_size = driver.vnodes_size - driver.hnodes_size;
+  arena.reserve(driver.hnodes_size, driver.vnodes_size);
+  driver.hnodes = arena.hnodes;
+  driver.vnodes = arena.vnodes;
+  driver.page_size = arena.stats.page_size;
+  driver.pages = arena.stats.pages;
+
+  Dlx::HNode *hnodes = driver.hnodes;
+  Dlx::VNode *vnodes = driver.vnodes;
+  int h = driver.hnodes_size;
+  for (int i = 0; i < h; i++) {
+    hnodes[i] = {&hnodes[(i + h - 1) % h], &hnodes[(i + 1) % h]};
+    vnodes[i] = {0, &vnodes[i], &vnodes[i]};
+  }
+  vnodes[0] = {nullptr, nullptr, nullptr};
+
+  option_ids.resize(driver.vnodes_size);
+  costs.assign(driver.vnodes_size, 0);
+  driver.costs = costs.data();
+  int index = h;
+  Dlx::VNode *prev_spacer = nullptr;
+  std::string error;
+  for (std::uint32_t option = 0; option < option_lines.size(); option++) {
+    Dlx::VNode *first = prev_spacer ? prev_spacer + 1 : nullptr;
+    vnodes[index] = {nullptr, first, nullptr};
+    prev_spacer = &vnodes[index];
+    index++;
+
+    double cost = 0;
+    forEachToken(option_lines[option], [&](std::string_view name) {
+      // A token starting with $ gives the option's cost
+      if (name[0] == '$') {
+        auto [end, ec] =
+            std::from_chars(name.data() + 1, name.data() + name.size(), cost);
+        if (ec != std::errc() || end != name.data() + name.size()) {
+          error = "Failed to parse cost: " + std::string(name) + "\n";
+        } else if (!std::isfinite(cost) || cost < 0) {
+          error = "Cost must be finite and not negative: " + std::string(name) +
+                  "\n";
+        }
+        return;
+      }
+      auto item = std::lower_bound(
+          items.begin(), items.end(), name,
+          [](auto &a, std::string_view b) { return a.first < b; });
+      if (item == items.end() || item->first != name) {
+        error = "Error item: " + std::string(name) + " not in input\n";
+        return;
+      }
+
+      Dlx::VNode *top = &vnodes[item->second];
+      Dlx::VNode *bottom = top->up;
+      vnodes[index] = {top, bottom, top};
+      top->up = &vnodes[index];
+      bottom->down = &vnodes[index];
+      top->size++;
+      option_ids[index] = option;
+      index++;
+    });
+    if (!error.empty()) {
+      return error;
+    }
+    std::fill(costs.begin() + (prev_spacer - vnodes) + 1,
+              costs.begin() + index, cost);
+    prev_spacer->down = &vnodes[index - 1];
+  }
+  vnodes[index] = {nullptr, prev_spacer ? prev_spacer + 1 : nullptr, nullptr};
+
+  return {};
+}
+
+void BatchWorker::solve(BatchInstance &instance, bool all, bool count) {
+  DLX_TRACE_SPAN("instance");
+  std::string &output = instance.output;
+  output.clear();
+  output += "--- ";
+  output += instance.tag;
+  output += '\n';
+
+  std::string error = parse(instance.text);
+  if (!error.empty()) {
+    output += "error: ";
+    output += error;
+    return;
+  }
+
+  if (dlx.config.minimize) {
+    // Each solution visited is cheaper than the last
+    cheapest.clear();
+    std::uint64_t found =
+        dlx.solveAll(&driver, [this](std::span<Dlx::VNode *const> solution) {
+          cheapest.clear();
+          for (Dlx::VNode *i : solution) {
+            cheapest.push_back(option_ids[i - driver.vnodes]);
+          }
+          return true;
+        });
+    if (found == 0) {
+      output += "no solution\n";
+      return;
+    }
+
+    char cost[32];
+    output += "cost: ";
+    output.append(cost, std::to_chars(cost, cost + sizeof(cost), dlx.best).ptr);
+    output += '\n';
+    for (std::uint32_t id : cheapest) {
+      output += option_lines[id];
+      output += '\n';
+    }
+    return;
+  }
+
+  struct Context {
+    std::string &output;
+    bool all;
+    bool count;
+    std::uint64_t found;
+  } context{output, all, count, 0};
+  // Two pointers keep std::function from allocating
+  dlx.solveAll(&driver, [this, &context](
+                            std::span<Dlx::VNode *const> solution) {
+    if (!context.count) {
+      if (context.found > 0) {
+        context.output += '\n';
+      }
+      for (Dlx::VNode *i : solution) {
+        context.output += option_lines[option_ids[i - driver.vnodes]];
+        context.output += '\n';
+      }
+    }
+    context.found++;
+    return context.all || context.count;
+  });
+
+  if (count) {
+    output += "solutions: ";
+    output += std::to_string(context.found);
+    output += '\n';
+  } else if (context.found == 0) {
+    output += "no solution\n";
+  }
+}
+
+std::size_t Batch::read(std::istream &in, std::vector<BatchInstance> &chunk) {
+  std::size_t size = 0;
+  std::string line;
+  while (size < chunk.size() && std::getline(in, line)) {
+    if (line.starts_with("---")) {
+      if (open) {
+        size++;
+        open = false;
+      }
+      std::string_view tag = std::string_view(line).substr(3);
+      while (!tag.empty() && std::isspace(tag.front())) {
+        tag.remove_prefix(1);
+      }
+      while (!tag.empty() && std::isspace(tag.back())) {
+        tag.remove_suffix(1);
+      }
+      next_tag = tag;
+      continue;
+    }
+
+    if (!open) {
+      // Blank lines between instances
+      if (line.empty()) {
+        continue;
+      }
+      BatchInstance &instance = chunk[size];
+      if (next_tag.empty()) {
+        instance.tag = std::to_string(number);
+      } else {
+        instance.tag = next_tag;
+        next_tag.clear();
+      }
+      instance.text.clear();
+      number++;
+      open = true;
+    }
+    chunk[size].text += line;
+    chunk[size].text += '\n';
+  }
+
+  if (open && size < chunk.size() && in.eof()) {
+    size++;
+    open = false;
+  }
+  return size;
+}
+
+void Batch::solve(std::vector<BatchInstance> &chunk, std::size_t size) {
+  std::atomic<std::size_t> next = 0;
+  std::vector<std::jthread> pool;
+  for (auto &worker : workers) {
+    pool.emplace_back([&, worker = worker.get()] {
+      for (std::size_t i = next++; i < size; i = next++) {
+        worker->solve(chunk[i], all, count);
+      }
+    });
+  }
+}
+
+bool Batch::run(std::istream &in, SolutionWriter &writer) {
+  workers.clear();
+  for (int i = 0; i < std::max(threads, 1); i++) {
+    workers.push_back(std::make_unique<BatchWorker>());
+    workers.back()->dlx.config = config;
+    workers.back()->arena.config = arena;
+  }
+  chunks[0].resize(chunk_size);
+  chunks[1].resize(chunk_size);
+
+  int current = 0;
+  std::size_t size = read(in, chunks[current]);
+  while (size > 0) {
+    // Read the next chunk while the workers solve this one
+    std::size_t next_size;
+    {
+      std::jthread solver([&] { solve(chunks[current], size); });
+      next_size = read(in, chunks[1 - current]);
+    }
+
+    for (std::size_t i = 0; i < size; i++) {
+      writer.append(chunks[current][i].output);
+    }
+    current = 1 - current;
+    size = next_size;
+  }
+  return writer.flush();
+}
@@ -0,0 +1,82 @@
+/*
+ * Batch mode for the CLI
+ *
+ * Solves a stream of small instances in one process. Each instance is
+ * written as for a single solve, items on the first line and one option
+ * per line, and instances are separated by lines starting with ---. The
+ * rest of a separator line tags the instance after it, otherwise the tag
+ * is the instance's number counting from 0.
+ *
+ * The reader fills one chunk of instances while a pool of workers solves
+ * the one before, and results are written in input order, each under a
+ * line --- <tag>. Every worker keeps its parser buffers, node arena and
+ * solver between instances, so once it has seen its largest instance,
+ * solving allocates next to nothing.
+ *
+ * Options may give a cost as in a single solve, and when minimizing each
+ * result is the cheapest solution after a line cost: <cost>. Symmetries
+ * are not read, and output is always text.
+ */
+
+#pragma once
+
+#include "../dlx.h"
+#include "../dlx_arena.h"
+#include "../dlx_output.h"
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+struct BatchInstance {
+  std::string tag;
+  std::string text;
+  std::string output;
+};
+
+struct BatchWorker {
+  Dlx dlx;
+  NodeArena arena;
+  Dlx::Driver driver;
+
+  // Item names sorted for lookup, and the line and node range of each
+  // option, all pointing into the instance's text
+  std::vector<std::pair<std::string_view, int>> items;
+  std::vector<std::string_view> lines;
+  std::vector<std::string_view> option_lines;
+  std::vector<std::uint32_t> option_ids;
+  std::vector<double> costs;
+
+  // Cheapest solution so far when minimizing
+  std::vector<std::uint32_t> cheapest;
+
+  std::string parse(std::string_view text);
+  void solve(BatchInstance &instance, bool all, bool count);
+};
+
+struct Batch {
+  Dlx::Config config;
+  NodeArena::Config arena;
+  bool all = false;
+  bool count = false;
+  int threads = 1;
+  std::size_t chunk_size = 4096;
+
+  std::vector<std::unique_ptr<BatchWorker>> workers;
+  std::vector<BatchInstance> chunks[2];
+
+  // Reader state carried between chunks
+  std::uint64_t number = 0;
+  std::string next_tag;
+  bool open = false;
+
+  std::size_t read(std::istream &in, std::vector<BatchInstance> &chunk);
+  void solve(std::vector<BatchInstance> &chunk, std::size_t size);
+
+  // Returns false if writing failed
+  bool run(std::istream &in, SolutionWriter &writer);
+};
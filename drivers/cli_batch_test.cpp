@@ -0,0 +1,176 @@
+#include "cli_batch_test.h"
+#include "cli_driver.h"
+#include "../dancing_cells_test.h"
+
+#include <charconv>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Sum the costs of an instance's option lines, returning false unless
+// they cover each of the items exactly once
+static bool coverCost(std::string_view lines, int items, double &cost) {
+  std::vector<int> covered(items + 1);
+  cost = 0;
+  std::istringstream in{std::string(lines)};
+  std::string token;
+  while (in >> token) {
+    if (token[0] == '$') {
+      cost += std::stod(token.substr(1));
+    } else {
+      covered[std::stoi(token.substr(1))]++;
+    }
+  }
+  for (int i = 1; i <= items; i++) {
+    if (covered[i] != 1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void BatchTest::compareMinCost(int count, std::uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  std::string input;
+  std::vector<int> item_counts;
+  std::vector<double> expected;
+  for (int n = 0; n < count; n++) {
+    int items = 2 + rng() % 10;
+    std::vector<std::vector<int>> options =
+        randomOptions(items, 1 + rng() % 20, rng);
+
+    // Items i1 up to i<items>, some options without a cost
+    RandomDriver driver;
+    driver.generate(items, options);
+    std::vector<double> costs(driver.vnodes_size);
+    input += "--- t" + std::to_string(n) + "\n";
+    for (int i = 1; i <= items; i++) {
+      input += (i > 1 ? " i" : "i") + std::to_string(i);
+    }
+    input += "\n";
+    int node = driver.hnodes_size;
+    for (auto &option : options) {
+      double cost = rng() % 8 == 0 ? 0 : (rng() % 40) / 4.0;
+      node++;
+      for (int i : option) {
+        input += "i" + std::to_string(i) + " ";
+        costs[node++] = cost;
+      }
+      if (cost != 0 || rng() % 2 == 0) {
+        char text[32];
+        input += "$";
+        input.append(text, std::to_chars(text, text + sizeof(text), cost).ptr);
+      }
+      input += "\n";
+    }
+    driver.costs = costs.data();
+
+    Dlx dlx;
+    std::vector<Dlx::VNode *> solution = dlx.solveMinCost(&driver);
+    item_counts.push_back(items);
+    expected.push_back(solution.empty() ? -1 : dlx.best);
+  }
+
+  // Small chunks so instances are read while others are solved
+  Batch batch;
+  batch.config.minimize = true;
+  batch.threads = 3;
+  batch.chunk_size = 16;
+  std::FILE *file = std::tmpfile();
+  SolutionWriter writer;
+  writer.open(fileno(file), SolutionFormat::Text);
+  std::istringstream in(input);
+  if (!batch.run(in, writer)) {
+    std::cout << "FAILED to write batch output\n";
+  }
+
+  std::string output;
+  std::rewind(file);
+  char buffer[4096];
+  std::size_t n;
+  while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    output.append(buffer, n);
+  }
+  std::fclose(file);
+
+  // Results come in input order, each after its --- line
+  std::size_t begin = 0;
+  int failed = 0;
+  for (int k = 0; k < count; k++) {
+    std::string header = "--- t" + std::to_string(k) + "\n";
+    std::size_t end = output.find("\n--- ", begin);
+    end = end == std::string::npos ? output.size() : end + 1;
+    std::string_view block =
+        std::string_view(output).substr(begin, end - begin);
+    begin = end;
+
+    if (!block.starts_with(header)) {
+      failed++;
+      continue;
+    }
+    block.remove_prefix(header.size());
+    if (expected[k] < 0) {
+      failed += block != "no solution\n";
+      continue;
+    }
+
+    std::size_t line = block.find('\n');
+    double cost = -1;
+    double sum;
+    if (block.starts_with("cost: ")) {
+      std::from_chars(block.data() + 6, block.data() + line, cost);
+    }
+    failed += cost != expected[k] ||
+              !coverCost(block.substr(line + 1), item_counts[k], sum) ||
+              sum != cost;
+  }
+  if (failed != 0) {
+    std::cout << "FAILED " << failed << " batch minimize results\n";
+  }
+  std::cout << "Compared " << count << " batch minimize results\n";
+}
+
+void BatchTest::rejectFlags() {
+  std::vector<std::vector<const char *>> rejected = {
+      {"-b", "--format", "binary"},
+      {"-b", "--format", "packed"},
+      {"-b", "-e", "cells"},
+      {"-b", "-e", "bits"},
+      {"-b", "--symmetry", "detect"},
+      {"-b", "--estimate", "10"},
+      {"-nh", "1", "-nv", "1", "-m", "-e", "cells"},
+      {"-nh", "1", "-nv", "1", "-c", "-e", "bits"},
+      {"-nh", "1", "-nv", "1", "-m", "-t", "4"},
+      {"-nh", "1", "-nv", "1", "-a", "-t", "2"},
+      {"-nh", "1", "-nv", "1", "-t", "2", "-e", "cells"},
+  };
+  for (auto &flags : rejected) {
+    std::vector<char *> argv = {const_cast<char *>("cli")};
+    for (const char *flag : flags) {
+      argv.push_back(const_cast<char *>(flag));
+    }
+    CliDriver driver;
+    if (driver.generate(argv.size(), argv.data()).empty()) {
+      std::cout << "FAILED accepted";
+      for (const char *flag : flags) {
+        std::cout << " " << flag;
+      }
+      std::cout << "\n";
+    }
+  }
+  std::cout << "Rejected " << rejected.size() << " unsupported flag sets\n";
+}
+
+#ifdef CLI_BATCH_TEST_MAIN
+
+int main() {
+  BatchTest::compareMinCost(500, 1);
+  BatchTest::rejectFlags();
+  return 0;
+}
+
+#endif
@@ -0,0 +1,18 @@
+#pragma once
+#include "cli_batch.h"
+
+#include <cstdint>
+
+// Checks of batch mode against single solves and of the CLI flags it
+// rejects
+class BatchTest {
+public:
+  // Minimizing count random costed instances in one batch, across chunks
+  // and workers, gives each the cheapest cost Dlx finds alone and a cover
+  // of that cost
+  static void compareMinCost(int count, std::uint64_t seed);
+
+  // Flags batch mode does not support fail in CliDriver::generate, as do
+  // engines and threads outside the single solution search
+  static void rejectFlags();
+};
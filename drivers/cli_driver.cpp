@@ -1,13 +1,26 @@
 #include "cli_driver.h"
+#include "cli_batch.h"
 #include "cli_parser.h"
+#include "../dancing_cells.h"
+#include "../dlx_bitset.h"
+#include "../dlx_portfolio.h"
+#include "../dlx_trace.h"
 
 #include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <fcntl.h>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 
 std::string CliDriver::generateNodes(std::istream& in) {
+  DLX_TRACE_SPAN("generate nodes");
   std::unordered_map<std::string, Dlx::VNode*> items; 
   {
     std::string s;
@@ -15,6 +28,7 @@ std::string CliDriver::generateNodes(std::istream& in) {
 
     hnodes_safe.emplace_back(nullptr, &hnodes_safe[1]);
     vnodes_safe.emplace_back(nullptr, nullptr, nullptr);
+    item_names.emplace_back();
 
     int index = 1;
     auto i = s.cbegin();
@@ -23,12 +37,14 @@ std::string CliDriver::generateNodes(std::istream& in) {
       hnodes_safe.emplace_back(&hnodes_safe[index - 1], &hnodes_safe[index + 1]);
       vnodes_safe.emplace_back(0, &vnodes_safe[index], &vnodes_safe[index]);
       items[{i, j}] = &vnodes_safe[index];
+      item_names.emplace_back(i, j);
       i = j + 1;
       index++;
     }
 
     hnodes_safe.back().right = &hnodes_safe[0];
     hnodes_safe.front().left = &hnodes_safe[index - 1];
+    symmetry.item_count = index - 1;
   }
 
   // repeatedly get line and create the spacer and options for each line
@@ -43,12 +59,31 @@ std::string CliDriver::generateNodes(std::istream& in) {
     vnodes_safe.emplace_back(nullptr, prev_spacer + 1, nullptr);
     prev_spacer = &vnodes_safe.back();
     index++;
+    costs_safe.resize(index);
+    option_ids_safe.resize(index);
 
+    double cost = 0;
+    std::vector<int> option_items;
     auto i = s.cbegin();
     while (i < s.cend()) {
       auto j = std::find_if(i, s.cend(), [](auto k) { return std::isspace(k); });
       std::string t(i, j);
       i = j + 1;
+
+      // A token starting with $ gives the option's cost
+      if (t.size() > 0 && t[0] == '$') {
+        try {
+          cost = std::stod(t.substr(1));
+        }
+        catch (const std::exception&) {
+          return "Failed to parse cost: " + t + "\n";
+        }
+        // The search bounds assume no option lowers the cost of a cover
+        if (!std::isfinite(cost) || cost < 0) {
+          return "Cost must be finite and not negative: " + t + "\n";
+        }
+        continue;
+      }
       
       auto item = items.find(t);
       if (item == items.end()) {
@@ -62,51 +97,315 @@ std::string CliDriver::generateNodes(std::istream& in) {
       Dlx::VNode* current = &vnodes_safe[index];
       top->up = current;
       bottom->down = current;
-
-      options[current] = s;
+      top->size++;
+      option_items.push_back(top - vnodes_safe.data());
 
       index++;
     }
     prev_spacer->down = &vnodes_safe[index - 1];
+    costs_safe.resize(index, cost);
+    option_ids_safe.resize(index, option_lines.size());
+    option_lines.push_back(s);
+    // Costs only constrain symmetries when minimizing
+    symmetry.addOption(std::move(option_items), config.minimize ? cost : 0);
   }
   
   vnodes_safe.emplace_back(nullptr, prev_spacer + 1, nullptr);
+  costs_safe.resize(vnodes_safe.size());
+  option_ids_safe.resize(vnodes_safe.size());
+
+  // option_lines no longer moves
+  writer.lines.assign(option_lines.begin(), option_lines.end());
+
+  return generateSymmetries(in);
+}
+
+// Each line is a permutation of the items in cycle notation, as in
+// (a b c)(d e), and items in no cycle stay put
+std::string CliDriver::generateSymmetries(std::istream& in) {
+  std::unordered_map<std::string_view, int> index;
+  for (std::size_t i = 1; i < item_names.size(); i++) {
+    index[item_names[i]] = i;
+  }
+
+  std::string s;
+  while (std::getline(in, s)) {
+    if (s.size() == 0) {
+      continue;
+    }
+
+    std::vector<int> item_map(item_names.size());
+    for (std::size_t i = 0; i < item_map.size(); i++) {
+      item_map[i] = i;
+    }
+
+    std::vector<int> cycle;
+    auto i = s.cbegin();
+    while (i < s.cend()) {
+      auto j = std::find_if(i, s.cend(), [](auto k) {
+        return std::isspace(k) || k == '(' || k == ')';
+      });
+      if (j != i) {
+        auto item = index.find({i, j});
+        if (item == index.end()) {
+          return "Error item: " + std::string(i, j) + " not in input\n";
+        }
+        cycle.push_back(item->second);
+      }
+      if (j < s.cend() && *j == ')') {
+        for (std::size_t k = 0; k < cycle.size(); k++) {
+          item_map[cycle[k]] = cycle[(k + 1) % cycle.size()];
+        }
+        cycle.clear();
+      }
+      i = j + 1;
+    }
+    if (!cycle.empty()) {
+      return "Unclosed cycle in symmetry: " + s + "\n";
+    }
 
+    std::string error = symmetry.addGenerator(item_map);
+    if (!error.empty()) {
+      return error;
+    }
+  }
   return {};
 }
 
+// Unlink the options the symmetry group made redundant
+void CliDriver::removeSymmetricOptions() {
+  for (std::size_t i = hnodes_safe.size(); i < vnodes_safe.size(); i++) {
+    Dlx::VNode& node = vnodes_safe[i];
+    if (node.top != nullptr && symmetry.removed(option_ids_safe[i])) {
+      node.up->down = node.down;
+      node.down->up = node.up;
+      node.top->size--;
+    }
+  }
+}
+
 std::string CliDriver::generate(int argc, char** argv) {
   CliParser parser;
   std::string items_count;
   std::string options_count;
-  std::string in_filename;
+  std::string seed;
+  std::string restart;
+  std::string restart_base;
+  std::string threads_count;
+  std::string engine;
+  std::string learn_memory;
+  std::string weight_decay;
+  std::string estimate;
+  std::string progress;
+  std::string output;
+  std::string page_kind;
+  std::string symmetry_mode;
+  std::string numa;
 
   if (argc == 1) {
-    return "Usage: -nh <int> -nv <int> [-f <input-filename>]\n";
+    return "Usage: -nh <int> -nv <int> [-f <input-filename>] [-r] [-s <seed>]"
+           " [--restart luby|geometric] [--restart-base <nodes>]"
+           " [-t <threads>] [-e dlx|cells|bits] [-m]"
+           " [-l] [--learn-memory <MB>] [--forward-check]"
+           " [-w] [--weight-decay <factor>]"
+           " [--estimate <probes>] [--progress <seconds>]"
+           " [-a] [-o <output-filename>] [--format text|binary|packed]"
+           " [--pages normal|thp|2m|1g] [--prefault] [--numa <node>|local]"
+           " [--memory-stats] [-c] [--symmetry declared|detect] [-b]"
+           " [--trace <trace-filename>]\n";
   }
 
   parser.addOption("-nh,--item-count", &items_count);
   parser.addOption("-nv,--option-count", &options_count);
   parser.addOption("-f,--input-file", &in_filename);
+  parser.addOption("-r,--randomize", &config.randomize);
+  parser.addOption("-s,--seed", &seed);
+  parser.addOption("--restart", &restart);
+  parser.addOption("--restart-base", &restart_base);
+  parser.addOption("-t,--threads", &threads_count);
+  parser.addOption("-e,--engine", &engine);
+  parser.addOption("-m,--minimize", &config.minimize);
+  parser.addOption("-l,--learn", &config.learn);
+  parser.addOption("--learn-memory", &learn_memory);
+  parser.addOption("--forward-check", &config.forward_check);
+  parser.addOption("-w,--weighted", &config.weighted);
+  parser.addOption("--weight-decay", &weight_decay);
+  parser.addOption("--estimate", &estimate);
+  parser.addOption("--progress", &progress);
+  parser.addOption("-a,--all", &all);
+  parser.addOption("-o,--output-file", &out_filename);
+  parser.addOption("--format", &output);
+  parser.addOption("--pages", &page_kind);
+  parser.addOption("--prefault", &arena.config.prefault);
+  parser.addOption("--numa", &numa);
+  parser.addOption("--memory-stats", &config.measure_memory);
+  parser.addOption("-c,--count", &count);
+  parser.addOption("--symmetry", &symmetry_mode);
+  parser.addOption("-b,--batch", &batch);
+  parser.addOption("--trace", &trace_filename);
   
   std::string error = parser.parse(argc, argv);
 
   if (!error.empty()) {
     return error;
   }
+
+#ifndef DLX_TRACE
+  if (!trace_filename.empty()) {
+    return "Tracing needs a build with DLX_TRACE defined\n";
+  }
+#endif
   
+  // Batch instances size themselves
   try {
-    std::size_t nh, nv;
-    nh = std::stoi(items_count, &nh);
-    nv = std::stoi(options_count, &nv);
+    if (!batch) {
+      std::size_t nh, nv;
+      nh = std::stoi(items_count, &nh);
+      nv = std::stoi(options_count, &nv);
 
-    hnodes_safe.reserve(nh);
-    vnodes_safe.reserve(nv);
+      hnodes_safe.reserve(nh);
+      vnodes_safe.reserve(nv);
+    }
   }
-  catch(std::exception e) {
+  catch (const std::exception&) {
     return "Failed to parse item count(-nh) and option count(-nv)\n";
   }
 
+  try {
+    if (!seed.empty()) {
+      config.seed = std::stoull(seed);
+    }
+    if (!restart_base.empty()) {
+      config.restart_base = std::stoull(restart_base);
+    }
+    if (!threads_count.empty()) {
+      threads = std::stoi(threads_count);
+    }
+    if (!learn_memory.empty()) {
+      config.learn_memory = std::stoull(learn_memory) << 20;
+    }
+    if (!weight_decay.empty()) {
+      config.weight_decay = std::stod(weight_decay);
+    }
+    if (!estimate.empty()) {
+      estimate_probes = std::stoi(estimate);
+    }
+    if (!progress.empty()) {
+      progress_interval = std::stod(progress);
+    }
+    if (numa == "local") {
+      arena.config.numa_node = NodeArena::local_node;
+    }
+    else if (!numa.empty()) {
+      arena.config.numa_node = std::stoi(numa);
+    }
+  }
+  catch (const std::exception&) {
+    return "Failed to parse seed(-s), restart base, thread count(-t),"
+           " learn memory, weight decay, estimate probes, progress interval"
+           " or numa node\n";
+  }
+
+  if (config.weight_decay <= 0 || config.weight_decay > 1) {
+    return "Weight decay must be in (0, 1]\n";
+  }
+
+  if (page_kind == "thp") {
+    arena.config.pages = NodeArena::Pages::Transparent;
+  }
+  else if (page_kind == "2m") {
+    arena.config.pages = NodeArena::Pages::Huge2M;
+  }
+  else if (page_kind == "1g") {
+    arena.config.pages = NodeArena::Pages::Huge1G;
+  }
+  else if (!page_kind.empty() && page_kind != "normal") {
+    return "Unknown page size: " + page_kind + "\n";
+  }
+
+  if (symmetry_mode == "detect") {
+    detect_symmetry = true;
+  }
+  else if (!symmetry_mode.empty() && symmetry_mode != "declared") {
+    return "Unknown symmetry mode: " + symmetry_mode + "\n";
+  }
+
+  if (restart == "luby") {
+    config.restart = Dlx::Restart::Luby;
+  }
+  else if (restart == "geometric") {
+    config.restart = Dlx::Restart::Geometric;
+  }
+  else if (!restart.empty()) {
+    return "Unknown restart schedule: " + restart + "\n";
+  }
+
+  if (engine == "cells") {
+    dancing_cells = true;
+  }
+  else if (engine == "bits") {
+    bitset = true;
+  }
+  else if (!engine.empty() && engine != "dlx") {
+    return "Unknown engine: " + engine + "\n";
+  }
+
+  SolutionFormat format = SolutionFormat::Text;
+  if (output == "binary") {
+    format = SolutionFormat::Binary;
+  }
+  else if (output == "packed") {
+    format = SolutionFormat::Packed;
+  }
+  else if (!output.empty() && output != "text") {
+    return "Unknown output format: " + output + "\n";
+  }
+
+  // Batch results are tagged text blocks solved by plain Dlx workers
+  if (batch) {
+    if (format != SolutionFormat::Text) {
+      return "Batch mode only writes text output\n";
+    }
+    if (dancing_cells || bitset) {
+      return "Batch mode only runs the dlx engine\n";
+    }
+    if (!symmetry_mode.empty()) {
+      return "Batch mode does not read symmetries\n";
+    }
+    if (estimate_probes > 0) {
+      return "Batch mode does not estimate\n";
+    }
+  }
+  else {
+    // Other engines and threads only search for one solution, listing,
+    // counting, minimizing and estimating always run plain Dlx
+    bool one_solution =
+        !all && !count && !config.minimize && estimate_probes == 0;
+    if ((dancing_cells || bitset) && !one_solution) {
+      return "The cells and bits engines only find one solution\n";
+    }
+    if (threads > 1 && !one_solution) {
+      return "Threads only search for one solution\n";
+    }
+    if (threads > 1 && (dancing_cells || bitset)) {
+      return "Threads only run the dlx engine\n";
+    }
+  }
+
+  int fd = 1;
+  if (!out_filename.empty()) {
+    fd = ::open(out_filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      return "Failed to open file: " + out_filename + "\n";
+    }
+  }
+
+  // The instances are read as they are solved
+  if (batch) {
+    writer.open(fd, format);
+    return {};
+  }
+
   if (in_filename.empty()) {
     error = generateNodes(std::cin);
   }
@@ -119,26 +418,115 @@ std::string CliDriver::generate(int argc, char** argv) {
       error = generateNodes(in);
       fb.close();
     }
-    catch (std::exception e) {
+    catch (const std::exception&) {
       return "Failed to open file: "  + in_filename + "\n";
     }
   }
 
   hnodes = hnodes_safe.data();
   vnodes = vnodes_safe.data();
+  costs = costs_safe.data();
+  hnodes_size = hnodes_safe.size();
+  vnodes_size = vnodes_safe.size();
   solution_size = vnodes_safe.size() - hnodes_safe.size();
 
+  if (!error.empty()) {
+    return error;
+  }
+  // The binary headers give the option count, known once the input is read
+  writer.open(fd, format, option_lines.size());
+
+  if (detect_symmetry) {
+    symmetry.detectGrid(item_names);
+  }
+  if (!symmetry.generators.empty()) {
+    error = symmetry.close();
+    if (!error.empty()) {
+      return error;
+    }
+    removeSymmetricOptions();
+  }
+
+  // Move the matrix into the arena, the vectors were only needed to build it
+  arena.assign(this);
+  hnodes = arena.hnodes;
+  vnodes = arena.vnodes;
+  page_size = arena.stats.page_size;
+  pages = arena.stats.pages;
+  hnodes_safe = {};
+  vnodes_safe = {};
+
   return error;
 }
 
-void CliDriver::prettyPrintSolution(const std::vector<Dlx::VNode*> solution) {
+std::span<const std::uint32_t> CliDriver::solutionIds(
+    std::span<Dlx::VNode* const> solution) {
+  solution_ids.clear();
   for (auto i : solution) {
-    std::cout << options.at(i) << "\n";
+    solution_ids.push_back(option_ids_safe[i - vnodes]);
   }
+  return solution_ids;
 }
 
+void CliDriver::writeSolution(std::span<Dlx::VNode* const> solution) {
+  writer.write(solutionIds(solution));
+}
+
+// The batch test links the driver with its own main
+#ifndef CLI_BATCH_TEST_MAIN
+
 #include <iostream>
 
+static std::atomic<bool> progress_requested;
+
+static void requestProgress(int) {
+  progress_requested.store(true, std::memory_order_relaxed);
+}
+
+// Report progress to stderr on SIGUSR1, and every interval seconds if set
+static std::jthread reportProgress(Dlx& dlx, double interval) {
+  std::signal(SIGUSR1, requestProgress);
+  dlx.report = &progress_requested;
+  dlx.progress = [](const Dlx::Progress& progress) {
+    std::cerr << "depth " << progress.level
+              << " explored " << progress.explored * 100 << "%"
+              << " nodes " << progress.nodes
+              << " nodes/s " << progress.nodes_per_second << "\n";
+  };
+
+  if (interval <= 0) {
+    return {};
+  }
+  return std::jthread([interval](std::stop_token stop) {
+    std::mutex mutex;
+    std::condition_variable_any timer;
+    std::unique_lock lock(mutex);
+    auto period = std::chrono::duration<double>(interval);
+    while (!timer.wait_for(lock, stop, period, [] { return false; })) {
+      if (stop.stop_requested()) {
+        break;
+      }
+      requestProgress(SIGUSR1);
+    }
+  });
+}
+
+static void printMemoryStats(const Dlx::Stats& stats) {
+  std::cerr << "page size " << stats.page_size
+            << " pages " << stats.pages
+            << " page faults " << stats.page_faults
+            << " tlb misses " << stats.tlb_misses << "\n";
+}
+
+static int writeTrace(const CliDriver& driver, int status) {
+  if (!driver.trace_filename.empty() &&
+      !Trace::writeChrome(driver.trace_filename)) {
+    std::cerr << "Failed to write trace: " << driver.trace_filename << "\n";
+    return 1;
+  }
+  return status;
+}
+
 int main(int argc, char** argv) {
   CliDriver driver;
   std::string s = driver.generate(argc, argv);
@@ -147,10 +535,116 @@ int main(int argc, char** argv) {
     std::cerr << s;
     exit(1);
   }
-  Dlx dlx;
-  auto solution = dlx.solve(&driver);
+  if (driver.batch) {
+    Batch batch;
+    batch.config = driver.config;
+    batch.arena = driver.arena.config;
+    batch.all = driver.all;
+    batch.count = driver.count;
+    batch.threads = driver.threads;
 
-  driver.prettyPrintSolution(solution);
+    bool written;
+    if (driver.in_filename.empty()) {
+      written = batch.run(std::cin, driver.writer);
+    }
+    else {
+      std::ifstream in(driver.in_filename);
+      if (!in) {
+        std::cerr << "Failed to open file: " << driver.in_filename << "\n";
+        return 1;
+      }
+      written = batch.run(in, driver.writer);
+    }
+    if (!written) {
+      std::cerr << "Failed to write solutions\n";
+      return 1;
+    }
+    return writeTrace(driver, 0);
+  }
+
+  if (driver.estimate_probes > 0) {
+    Dlx dlx;
+    dlx.config = driver.config;
+    Dlx::Estimate estimate = dlx.estimate(&driver, driver.estimate_probes);
+    std::cout << "nodes: " << estimate.nodes << "\n"
+              << "solutions: " << estimate.solutions << "\n"
+              << "seconds: " << estimate.seconds << "\n";
+    return writeTrace(driver, 0);
+  }
 
-  return 0;
+  std::vector<Dlx::VNode*> solution;
+  Dlx::Stats memory_stats;
+  std::uint64_t raw_count = 0;
+  std::uint64_t orbit_count = 0;
+  if ((driver.all || driver.count) && !driver.config.minimize) {
+    Dlx dlx;
+    dlx.config = driver.config;
+    auto reporter = reportProgress(dlx, driver.progress_interval);
+    // Each solution found stands for its weight in raw solutions, and only
+    // canonical ones are written, one per orbit
+    dlx.solveAll(&driver, [&](std::span<Dlx::VNode* const> found) {
+      std::span<const std::uint32_t> ids = driver.solutionIds(found);
+      raw_count += driver.symmetry.weight(ids);
+      if (driver.symmetry.canonical(ids)) {
+        orbit_count++;
+        if (driver.all) {
+          driver.writer.write(ids);
+        }
+      }
+      return true;
+    });
+    memory_stats = dlx.stats;
+  }
+  else if (driver.config.minimize) {
+    Dlx dlx;
+    dlx.config = driver.config;
+    auto reporter = reportProgress(dlx, driver.progress_interval);
+    solution = dlx.solveMinCost(&driver);
+    memory_stats = dlx.stats;
+    if (!solution.empty()) {
+      std::cout << "cost: " << dlx.best << std::endl;
+    }
+  }
+  else if (driver.dancing_cells) {
+    DancingCells cells;
+    solution = cells.solve(&driver);
+  }
+  else if (driver.bitset) {
+    BitsetDlx bits;
+    solution = bits.solve(&driver);
+  }
+  else if (driver.threads > 1) {
+    Portfolio portfolio;
+    portfolio.addSeeded(driver.config, driver.threads);
+    portfolio.arena = driver.arena.config;
+    solution = portfolio.solve(&driver);
+    memory_stats = portfolio.stats;
+  }
+  else {
+    Dlx dlx;
+    dlx.config = driver.config;
+    auto reporter = reportProgress(dlx, driver.progress_interval);
+    solution = dlx.solve(&driver);
+    memory_stats = dlx.stats;
+  }
+
+  if (driver.config.measure_memory) {
+    printMemoryStats(memory_stats);
+  }
+
+  if (!solution.empty()) {
+    driver.writeSolution(solution);
+  }
+  if (!driver.writer.flush()) {
+    std::cerr << "Failed to write solutions\n";
+    return 1;
+  }
+  if (driver.count) {
+    std::cout << "solutions: " << raw_count << "\n"
+              << "modulo symmetry: " << orbit_count << "\n";
+  }
+
+  return writeTrace(driver, 0);
 }
+
+#endif
@@ -1,19 +1,68 @@
 #pragma once 
 
 #include "../dlx.h"
+#include "../dlx_arena.h"
+#include "../dlx_output.h"
+#include "../dlx_symmetry.h"
 
+#include <cstdint>
+#include <span>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 class CliDriver : public Dlx::Driver {
 public:
   std::vector<Dlx::HNode> hnodes_safe;
   std::vector<Dlx::VNode> vnodes_safe;
+  std::vector<double> costs_safe;
 
-  std::unordered_map<Dlx::VNode*, std::string> options;
+  // Holds the nodes once built
+  NodeArena arena;
+
+  // Line of each option, and id of the option each node is in
+  std::vector<std::string> option_lines;
+  std::vector<std::uint32_t> option_ids_safe;
+
+  std::vector<std::string> item_names;
+
+  SolutionWriter writer;
+  std::vector<std::uint32_t> solution_ids;
+
+  // Symmetries declared after the options, in cycle notation over item
+  // names one per line, or detected from grid item names
+  SymmetryGroup symmetry;
+  bool detect_symmetry = false;
+
+  Dlx::Config config;
+  int threads = 1;
+  bool dancing_cells = false;
+  bool bitset = false;
+
+  // Probes to estimate the search with instead of solving, and seconds
+  // between progress reports, 0 for only on SIGUSR1
+  int estimate_probes = 0;
+  double progress_interval = 0;
+
+  // Write every solution rather than the first
+  bool all = false;
+  // Print the number of solutions, raw and modulo symmetry
+  bool count = false;
+
+  // Read a stream of instances, see cli_batch.h
+  bool batch = false;
+  std::string in_filename;
+  std::string out_filename;
+  // Chrome trace of the run, needs a build with DLX_TRACE
+  std::string trace_filename;
 
   std::string generateNodes(std::istream& in);
   std::string generate(int argc, char** argv);
 
-  void prettyPrintSolution(const std::vector<Dlx::VNode*> solution);
+  std::string generateSymmetries(std::istream& in);
+  void removeSymmetricOptions();
+
+  std::span<const std::uint32_t> solutionIds(
+      std::span<Dlx::VNode* const> solution);
+  void writeSolution(std::span<Dlx::VNode* const> solution);
 };
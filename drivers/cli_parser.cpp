@@ -1,16 +1,25 @@
 #include "cli_parser.h"
 
-void CliParser::addOption(std::string flags, std::string* out) {
+template <typename T>
+static void addFlags(CliParser& parser, const std::string& flags, T* out) {
   int start = 0;
   for (int end = 1; end <= flags.size(); end++) {
     if (flags[end] == '\0' || flags[end] == ',') {
-      options.emplace(std::string({&flags[start], &flags[end]}), out);
+      parser.options.emplace(std::string({&flags[start], &flags[end]}), out);
       start = end + 1;
       end = end + 2;
     }
   }
 }
 
+void CliParser::addOption(std::string flags, std::string* out) {
+  addFlags(*this, flags, out);
+}
+
+void CliParser::addOption(std::string flags, bool* out) {
+  addFlags(*this, flags, out);
+}
+
 std::string CliParser::parse(int argc, char** argv) {
   int i = 1;
   while(i < argc) {
@@ -8,6 +8,7 @@ struct CliParser {
   std::unordered_map<std::string, std::variant<std::string*, bool*>> options;
 
   void addOption(std::string flags, std::string* out);
+  void addOption(std::string flags, bool* out);
 
   std::string parse(int argc, char** argv);
 };
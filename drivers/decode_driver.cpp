@@ -0,0 +1,85 @@
+// Decode binary or packed solutions written by the CLI back to text. Given
+// the problem file each option is printed as its line, otherwise as its id.
+
+#include "cli_parser.h"
+#include "../dlx_output.h"
+
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+int main(int argc, char** argv) {
+  CliParser parser;
+  std::string in_filename;
+  std::string problem_filename;
+
+  parser.addOption("-i,--input-file", &in_filename);
+  parser.addOption("-f,--problem-file", &problem_filename);
+
+  std::string error = parser.parse(argc, argv);
+  if (!error.empty()) {
+    std::cerr << error
+              << "Usage: [-i <solutions-filename>] [-f <problem-filename>]\n";
+    return 1;
+  }
+
+  // Options are the lines after the items up to the first empty line
+  std::vector<std::string> lines;
+  if (!problem_filename.empty()) {
+    std::ifstream problem(problem_filename);
+    if (!problem) {
+      std::cerr << "Failed to open file: " << problem_filename << "\n";
+      return 1;
+    }
+    std::string s;
+    std::getline(problem, s);
+    while (std::getline(problem, s) && s.size() != 0) {
+      lines.push_back(s);
+    }
+  }
+
+  int fd = 0;
+  if (!in_filename.empty()) {
+    fd = ::open(in_filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      std::cerr << "Failed to open file: " << in_filename << "\n";
+      return 1;
+    }
+  }
+
+  SolutionReader reader;
+  if (!reader.open(fd)) {
+    std::cerr << "Not a binary or packed solution file\n";
+    return 1;
+  }
+
+  SolutionWriter writer;
+  writer.open(1, SolutionFormat::Text);
+  writer.lines.assign(lines.begin(), lines.end());
+
+  std::vector<std::uint32_t> ids;
+  while (reader.next(ids)) {
+    for (std::uint32_t id : ids) {
+      if (!lines.empty() && id >= lines.size()) {
+        std::cerr << "Option id " << id << " not in problem\n";
+        return 1;
+      }
+    }
+    writer.write(ids);
+  }
+
+  if (!writer.flush()) {
+    std::cerr << "Failed to write solutions\n";
+    return 1;
+  }
+  // The solutions before the damage are still written
+  if (reader.failed) {
+    std::cerr << "Truncated or corrupt solution file after "
+              << writer.count << " solutions\n";
+    return 1;
+  }
+  return 0;
+}
@@ -1,4 +1,5 @@
 #include "sudoku_driver.h"
+#include "../dlx_trace.h"
 
 #include <algorithm>
 #include <iostream>
@@ -20,6 +21,8 @@ int SudokuDriver::generatePuzzle(const std::string &puzzle_) {
 
   hnodes = hnodes_owner.data();
   vnodes = vnodes_owner.data();
+  hnodes_size = hnodes_owner.size();
+  vnodes_size = vnodes_owner.size();
   solution_size = hnodes_owner.size();
   puzzle = puzzle_;
 
@@ -53,6 +56,7 @@ std::unordered_map<int, int>
 SudokuDriver::generateHeaders(const std::vector<bool> &precover,
                               std::vector<Dlx::HNode> &hnodes,
                               std::vector<Dlx::VNode> &vnodes) {
+  DLX_TRACE_SPAN("generate headers");
   std::unordered_map<int, int> header_map;
 
   hnodes.emplace_back(nullptr, &hnodes[1]);
@@ -89,6 +93,7 @@ bool SudokuDriver::shouldSkipOption(
 void SudokuDriver::generateOptions(
     std::vector<Dlx::VNode> &vnodes,
     const std::unordered_map<int, int> &header_map) {
+  DLX_TRACE_SPAN("generate options");
   int index = vnodes.size();
   for (int i = 0; i < 9; i++) {
     for (int j = 0; j < 9; j++) {
@@ -106,6 +111,7 @@ void SudokuDriver::generateOptions(
           vnodes.emplace_back(top, bottom, top);
           top->up = &vnodes[index];
           bottom->down = &vnodes[index];
+          top->size++;
           option_map[&vnodes[index]] = {i, j, k};
           index++;
         }
@@ -156,24 +162,31 @@ SudokuDriver::translateSolution(const std::vector<Dlx::VNode *> &solution) {
 void SudokuDriver::prettyPrintSolution(
     const std::vector<Dlx::VNode *> &solution) {
   std::string s = translateSolution(solution);
+
+  // Format the grid first so it goes out in one write
+  std::string grid;
+  grid.reserve(256);
   for (int i = 0; i < 9; i++) {
     if ((i % 3) == 0) {
-      std::cout << "\n";
+      grid += '\n';
     }
-    std::cout << "\n";
+    grid += '\n';
     for (int j = 0; j < 9; j++) {
       if ((j % 3) == 0) {
-        std::cout << " ";
+        grid += ' ';
       }
-      std::cout << s[i * 9 + j] << " ";
+      grid += s[i * 9 + j];
+      grid += ' ';
     }
   }
-  std::cout << "\n\n\n";
+  grid += "\n\n\n";
+  std::cout.write(grid.data(), grid.size());
 }
 
 #ifdef SUDOKU_MAIN_IMPL
 
 #include "sudoku_driver_test.h"
+#include "../dlx_bitset.h"
 #include <iostream>
 
 inline void ltrim(std::string &s) {
@@ -199,7 +212,7 @@ int main() {
   std::cin >> s;
   trim(s);
 
-  Dlx dlx;
+  BitsetDlx dlx;
   SudokuDriver sudoku_driver;
 
   if (sudoku_driver.generatePuzzle(s) != 0) {
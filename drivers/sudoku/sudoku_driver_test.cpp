@@ -1,4 +1,5 @@
 #include "sudoku_driver_test.h"
+#include "sudoku_lazy_driver.h"
 
 #include <format>
 #include <iostream>
@@ -121,3 +122,50 @@ void SudokuDriverTest::validateNodes() {
   }
   std::cout << "Validated nodes\n";
 }
+
+void SudokuDriverTest::compareLazySolution() {
+  std::string puzzle = sudoku_driver->puzzle;
+  SudokuLazyDriver lazy_driver;
+  if (lazy_driver.generatePuzzle(puzzle) != 0) {
+    std::cout << "FAILED to generate lazy driver\n";
+    return;
+  }
+
+  LazyDlx lazy;
+  std::string lazy_solution =
+      lazy_driver.translateSolution(lazy.solve(&lazy_driver));
+
+  // Both search in the same order so find the same first solution
+  Dlx dlx;
+  std::string solution =
+      sudoku_driver->translateSolution(dlx.solve(sudoku_driver));
+  sudoku_driver->puzzle = puzzle;
+
+  if (lazy_solution != solution) {
+    std::cout << "FAILED lazy solution: " << lazy_solution
+              << " expected: " << solution << "\n";
+    return;
+  }
+  std::cout << "Lazy solution matches, generated " << lazy.stats.generated
+            << " options\n";
+}
+
+#ifdef SUDOKU_DRIVER_TEST_MAIN
+
+int main() {
+  // A puzzle that needs search rather than only forced placements
+  SudokuDriver sudoku_driver;
+  if (sudoku_driver.generatePuzzle("8..........36......7..9.2...5...7......."
+                                   "457.....1...3...1....68..85...1..9....4..") != 0) {
+    std::cout << "FAILED to generate driver\n";
+    return 1;
+  }
+
+  SudokuDriverTest test(&sudoku_driver);
+  test.validateGetEmptyTopIndex();
+  test.validateNodes();
+  test.compareLazySolution();
+  return 0;
+}
+
+#endif
@@ -12,4 +12,5 @@ public:
   void printVNodes();
   void printHeaderMap(const std::unordered_map<int, int> &header_map);
   void validateNodes();
+  void compareLazySolution();
 };
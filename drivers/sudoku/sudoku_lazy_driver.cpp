@@ -0,0 +1,79 @@
+#include "sudoku_lazy_driver.h"
+
+int SudokuLazyDriver::generatePuzzle(const std::string &puzzle_) {
+  if (puzzle_.size() != 81) {
+    return -1;
+  }
+
+  const std::vector<bool> precover = layout.generatePrecover(puzzle_);
+
+  item_count = 9 * 9 * 4;
+  items.clear();
+  for (int i = 0; i < item_count; i++) {
+    if (!precover[i + 1]) {
+      items.push_back(i);
+    }
+  }
+  puzzle = puzzle_;
+
+  return 0;
+}
+
+void SudokuLazyDriver::getOption(int item, int l, int &i, int &j,
+                                 int &k) const {
+  int a = item % 81 / 9;
+  int b = item % 9;
+  switch (item / 81) {
+  case 0:
+    i = a, j = b, k = l;
+    break;
+  case 1:
+    i = a, j = l, k = b;
+    break;
+  case 2:
+    i = l, j = a, k = b;
+    break;
+  case 3:
+    i = 3 * (a / 3) + l / 3, j = 3 * (a % 3) + l % 3, k = b;
+    break;
+  }
+}
+
+void SudokuLazyDriver::getOptionItems(int i, int j, int k,
+                                      int (&option_items)[4]) const {
+  for (int l = 0; l < 4; l++) {
+    option_items[l] = layout.getEmptyTopIndex(i, j, k, l) - 1;
+  }
+}
+
+void SudokuLazyDriver::generateOptions(int item, LazyDlx::Options &options) {
+  for (int l = 0; l < 9; l++) {
+    int i, j, k;
+    getOption(item, l, i, j, k);
+    int option_items[4];
+    getOptionItems(i, j, k, option_items);
+    options.add(i * 81 + j * 9 + k, option_items);
+  }
+}
+
+int SudokuLazyDriver::countOptions(int item,
+                                   const std::vector<char> &covered) {
+  int count = 0;
+  for (int l = 0; l < 9; l++) {
+    int i, j, k;
+    getOption(item, l, i, j, k);
+    int option_items[4];
+    getOptionItems(i, j, k, option_items);
+    count += !covered[option_items[0]] && !covered[option_items[1]] &&
+             !covered[option_items[2]] && !covered[option_items[3]];
+  }
+  return count;
+}
+
+std::string
+SudokuLazyDriver::translateSolution(std::span<const std::uint64_t> solution) {
+  for (auto i : solution) {
+    puzzle[i / 9] = '1' + i % 9;
+  }
+  return puzzle;
+}
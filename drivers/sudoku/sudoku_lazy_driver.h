@@ -0,0 +1,26 @@
+#pragma once
+
+#include "../dlx_lazy.h"
+#include "sudoku_driver.h"
+
+#include <string>
+
+// Generates the (row, col, digit) options of each item only when the
+// search asks for them. Items are numbered as in SudokuDriver less one.
+class SudokuLazyDriver : public LazyDlx::Driver {
+public:
+  // Only used for its item numbering
+  SudokuDriver layout;
+  std::string puzzle;
+
+  int generatePuzzle(const std::string &puzzle);
+
+  // The l-th of the 9 options containing item as (i, j, k)
+  void getOption(int item, int l, int &i, int &j, int &k) const;
+  void getOptionItems(int i, int j, int k, int (&option_items)[4]) const;
+
+  void generateOptions(int item, LazyDlx::Options &options) override;
+  int countOptions(int item, const std::vector<char> &covered) override;
+
+  std::string translateSolution(std::span<const std::uint64_t> solution);
+};